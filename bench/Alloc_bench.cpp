@@ -0,0 +1,44 @@
+#include "BenchUtils.hpp"
+#include "IRBuilder.hpp"
+#include "Optimizer.hpp"
+
+static constexpr int kGraphs = 1000;
+static constexpr int kChainLength = 50;
+
+// straight-line chain of foldable arithmetic in a loop-free graph
+static void BuildAndOptimize(std::unique_ptr<GraphAllocator> allocator) {
+    Graph graph(std::move(allocator));
+    IRBuilder builder(&graph);
+    auto* entry = graph.CreateNewBasicBlock();
+    graph.SetEntryBlock(entry);
+    builder.SetInsertPoint(entry);
+
+    Instruction* acc = builder.CreateParameter(Type::int32);
+    auto* one = builder.CreateConstant(Type::int32, 1);
+    auto* two = builder.CreateConstant(Type::int32, 2);
+    for (int i = 0; i < kChainLength; ++i) {
+        acc = builder.CreateMul(acc, one);
+        acc = builder.CreateOr(acc, builder.CreateMul(two, two));
+    }
+    builder.CreateReturn(acc);
+
+    Optimizer opt(&graph);
+    opt.Run();
+}
+
+template <typename Alloc>
+static void RunVariant(const std::string& name) {
+    size_t before = GetHeapAllocationCount();
+    BenchTimer timer;
+    for (int i = 0; i < kGraphs; ++i) {
+        BuildAndOptimize(std::make_unique<Alloc>());
+    }
+    PrintBenchRow(name, timer.ElapsedMs(), GetHeapAllocationCount() - before);
+}
+
+void BenchAllocation() {
+    std::cout << "=== Graph allocation: " << kGraphs << " graphs x "
+              << kChainLength * 4 << " instructions ===" << std::endl;
+    RunVariant<HeapAllocator>("heap (new per object)");
+    RunVariant<ArenaAllocator>("arena (bump + free lists)");
+}
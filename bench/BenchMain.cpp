@@ -0,0 +1,36 @@
+#include "BenchUtils.hpp"
+#include <cstdlib>
+#include <new>
+
+static size_t g_heap_allocations = 0;
+
+size_t GetHeapAllocationCount() { return g_heap_allocations; }
+
+void* operator new(size_t size) {
+    g_heap_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    g_heap_allocations++;
+    auto a = static_cast<size_t>(align);
+    if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+void BenchAllocation();
+void BenchReplaceAllUses();
+void BenchInstructionSize();
+
+int main() {
+    BenchAllocation();
+    BenchReplaceAllUses();
+    BenchInstructionSize();
+    return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Number of calls to the global operator new since program start,
+// maintained by the replacement operators in BenchMain.cpp.
+size_t GetHeapAllocationCount();
+
+class BenchTimer {
+public:
+    BenchTimer() : start_(std::chrono::steady_clock::now()) {}
+    double ElapsedMs() const {
+        auto d = std::chrono::steady_clock::now() - start_;
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+inline void PrintBenchRow(const std::string& name, double ms, size_t heap_allocs) {
+    std::cout << "  " << std::left << std::setw(36) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2) << ms << " ms"
+              << std::setw(12) << heap_allocs << " mallocs" << std::endl;
+}
@@ -0,0 +1,65 @@
+#include "BenchUtils.hpp"
+#include "IRBuilder.hpp"
+
+static constexpr int kGraphs = 2000;
+static constexpr int kBlocksPerGraph = 50;
+
+// diamond-shaped blocks with a handful of arithmetic instructions and a phi
+static size_t BuildGraph() {
+    Graph graph;
+    IRBuilder builder(&graph);
+    auto* entry = graph.CreateNewBasicBlock();
+    graph.SetEntryBlock(entry);
+    builder.SetInsertPoint(entry);
+    auto* param = builder.CreateParameter(Type::int32);
+    Instruction* acc = builder.CreateConstant(Type::int32, 1);
+    BasicBlock* cur = entry;
+    size_t count = 2;
+
+    for (int i = 0; i < kBlocksPerGraph; ++i) {
+        auto* left = graph.CreateNewBasicBlock();
+        auto* right = graph.CreateNewBasicBlock();
+        auto* merge = graph.CreateNewBasicBlock();
+        builder.SetInsertPoint(cur);
+        builder.CreateIf(builder.CreateCmp(acc, param), left, right);
+
+        builder.SetInsertPoint(left);
+        auto* l = builder.CreateAdd(acc, param);
+        builder.CreateJump(merge);
+
+        builder.SetInsertPoint(right);
+        auto* r = builder.CreateMul(acc, param);
+        builder.CreateJump(merge);
+
+        builder.SetInsertPoint(merge);
+        auto* phi = builder.CreatePhi(Type::int32);
+        phi->AddPhiInput(left, l);
+        phi->AddPhiInput(right, r);
+        acc = builder.CreateOr(phi, param);
+        cur = merge;
+        count += 8;
+    }
+    builder.SetInsertPoint(cur);
+    builder.CreateReturn(acc);
+    return count + 1;
+}
+
+void BenchInstructionSize() {
+    std::cout << "=== Instruction layout ===" << std::endl;
+    std::cout << "  sizeof(BinaryInst) = " << sizeof(BinaryInst)
+              << ", sizeof(PhiInst) = " << sizeof(PhiInst)
+              << ", sizeof(BasicBlock) = " << sizeof(BasicBlock) << std::endl;
+
+    size_t before = GetHeapAllocationCount();
+    size_t instructions = 0;
+    BenchTimer timer;
+    for (int i = 0; i < kGraphs; ++i) {
+        instructions += BuildGraph();
+    }
+    double ms = timer.ElapsedMs();
+    PrintBenchRow("IR construction", ms, GetHeapAllocationCount() - before);
+    std::cout << "  " << static_cast<double>(instructions) / ms / 1000.0
+              << " M instructions/s, "
+              << static_cast<double>(GetHeapAllocationCount() - before) / static_cast<double>(instructions)
+              << " mallocs/instruction" << std::endl;
+}
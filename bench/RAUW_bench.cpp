@@ -0,0 +1,84 @@
+#include "BenchUtils.hpp"
+#include "IRBuilder.hpp"
+#include "Optimizer.hpp"
+
+static constexpr int kInstructions = 100000;
+static constexpr int kReplacements = 1000;
+
+// The pre-use-list algorithm: visit every instruction of the graph.
+static void ScanReplaceAllUses(Graph* graph, Instruction* old_inst, Instruction* new_inst) {
+    for (auto& bb : graph->GetBlocks()) {
+        for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) {
+            inst->ReplaceInput(old_inst, new_inst);
+        }
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            inst->ReplaceInput(old_inst, new_inst);
+        }
+    }
+}
+
+// v[i] = v[i - 1] + p over kInstructions instructions
+static std::vector<Instruction*> BuildChain(Graph& graph) {
+    IRBuilder builder(&graph);
+    auto* entry = graph.CreateNewBasicBlock();
+    graph.SetEntryBlock(entry);
+    builder.SetInsertPoint(entry);
+
+    std::vector<Instruction*> chain;
+    auto* param = builder.CreateParameter(Type::int64);
+    Instruction* acc = param;
+    for (int i = 0; i < kInstructions; ++i) {
+        acc = builder.CreateAdd(acc, param);
+        chain.push_back(acc);
+    }
+    builder.CreateReturn(acc);
+    return chain;
+}
+
+template <typename Replace>
+static void RunReplacements(const std::string& name, Replace replace) {
+    Graph graph;
+    auto chain = BuildChain(graph);
+    IRBuilder builder(&graph);
+    builder.SetInsertPoint(graph.GetEntryBlock());
+    auto* zero = builder.CreateConstant(Type::int64, 0);
+
+    size_t before = GetHeapAllocationCount();
+    BenchTimer timer;
+    for (int i = 0; i < kReplacements; ++i) {
+        replace(&graph, chain[static_cast<size_t>(i) * (kInstructions / kReplacements)], zero);
+    }
+    PrintBenchRow(name, timer.ElapsedMs(), GetHeapAllocationCount() - before);
+}
+
+static void RunFolding() {
+    Graph graph;
+    IRBuilder builder(&graph);
+    auto* entry = graph.CreateNewBasicBlock();
+    graph.SetEntryBlock(entry);
+    builder.SetInsertPoint(entry);
+
+    auto* param = builder.CreateParameter(Type::int64);
+    auto* one = builder.CreateConstant(Type::int64, 1);
+    Instruction* acc = param;
+    for (int i = 0; i < kInstructions / 2; ++i) {
+        acc = builder.CreateMul(acc, one);
+        acc = builder.CreateAdd(acc, param);
+    }
+    builder.CreateReturn(acc);
+
+    BenchTimer timer;
+    Optimizer opt(&graph);
+    opt.Run();
+    PrintBenchRow("optimizer, fold 50k x*1", timer.ElapsedMs(), 0);
+}
+
+void BenchReplaceAllUses() {
+    std::cout << "=== Replace-all-uses: " << kReplacements << " replacements in a "
+              << kInstructions << "-instruction graph ===" << std::endl;
+    RunReplacements("graph scan (previous)", ScanReplaceAllUses);
+    RunReplacements("use lists", [](Graph*, Instruction* old_inst, Instruction* new_inst) {
+        old_inst->ReplaceAllUsesWith(new_inst);
+    });
+    RunFolding();
+}
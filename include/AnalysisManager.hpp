@@ -0,0 +1,122 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include "Graph.hpp"
+#include "PreservedAnalyses.hpp"
+#include "DominatorAnalysis.hpp"
+#include "LoopAnalyzer.hpp"
+#include "LinearOrderBuilder.hpp"
+#include "LivenessAnalysis.hpp"
+
+class AnalysisManager;
+
+template <typename T>
+struct AnalysisTraits;
+
+template <>
+struct AnalysisTraits<DominatorAnalysis> {
+    static constexpr AnalysisKind kind = AnalysisKind::Dominators;
+    static constexpr uint32_t deps = 0;
+    static std::unique_ptr<DominatorAnalysis> Compute(Graph* graph, AnalysisManager&) {
+        auto dom = std::make_unique<DominatorAnalysis>(graph);
+        dom->Run();
+        return dom;
+    }
+};
+
+template <>
+struct AnalysisTraits<LoopAnalyzer> {
+    static constexpr AnalysisKind kind = AnalysisKind::Loops;
+    static constexpr uint32_t deps = PreservedAnalyses::Bit(AnalysisKind::Dominators);
+    static std::unique_ptr<LoopAnalyzer> Compute(Graph* graph, AnalysisManager& am);
+};
+
+template <>
+struct AnalysisTraits<LinearOrderBuilder> {
+    static constexpr AnalysisKind kind = AnalysisKind::LinearOrder;
+    static constexpr uint32_t deps = PreservedAnalyses::Bit(AnalysisKind::Loops);
+    static std::unique_ptr<LinearOrderBuilder> Compute(Graph* graph, AnalysisManager& am);
+};
+
+template <>
+struct AnalysisTraits<LivenessAnalysis> {
+    static constexpr AnalysisKind kind = AnalysisKind::Liveness;
+    static constexpr uint32_t deps = PreservedAnalyses::Bit(AnalysisKind::LinearOrder);
+    static std::unique_ptr<LivenessAnalysis> Compute(Graph* graph, AnalysisManager& am);
+};
+
+// Computes analyses of one graph on first request and keeps them until a
+// transform reports that it did not preserve them. Dropping an analysis
+// also drops everything that was built from it.
+class AnalysisManager {
+public:
+    explicit AnalysisManager(Graph* graph) : graph_(graph) {}
+    AnalysisManager(const AnalysisManager&) = delete;
+    AnalysisManager& operator=(const AnalysisManager&) = delete;
+
+    template <typename T>
+    T& Get() {
+        auto& slot = std::get<std::unique_ptr<T>>(cache_);
+        if (!slot) {
+            slot = AnalysisTraits<T>::Compute(graph_, *this);
+            compute_count_[Index(AnalysisTraits<T>::kind)]++;
+        }
+        return *slot;
+    }
+
+    template <typename T>
+    bool IsCached() const { return std::get<std::unique_ptr<T>>(cache_) != nullptr; }
+
+    void Invalidate(const PreservedAnalyses& preserved) {
+        uint32_t dropped = 0;
+        InvalidateOne<DominatorAnalysis>(preserved, dropped);
+        InvalidateOne<LoopAnalyzer>(preserved, dropped);
+        InvalidateOne<LinearOrderBuilder>(preserved, dropped);
+        InvalidateOne<LivenessAnalysis>(preserved, dropped);
+    }
+    void InvalidateAll() { Invalidate(PreservedAnalyses::None()); }
+
+    // how many times the analysis has been (re)computed
+    size_t GetComputeCount(AnalysisKind kind) const { return compute_count_[Index(kind)]; }
+    Graph* GetGraph() const { return graph_; }
+
+private:
+    Graph* graph_;
+    std::tuple<std::unique_ptr<DominatorAnalysis>,
+               std::unique_ptr<LoopAnalyzer>,
+               std::unique_ptr<LinearOrderBuilder>,
+               std::unique_ptr<LivenessAnalysis>> cache_;
+    std::array<size_t, static_cast<size_t>(AnalysisKind::Count)> compute_count_ {};
+
+    static size_t Index(AnalysisKind kind) { return static_cast<size_t>(kind); }
+
+    template <typename T>
+    void InvalidateOne(const PreservedAnalyses& preserved, uint32_t& dropped) {
+        using Traits = AnalysisTraits<T>;
+        if (preserved.IsPreserved(Traits::kind) && (Traits::deps & dropped) == 0) return;
+        std::get<std::unique_ptr<T>>(cache_).reset();
+        dropped |= PreservedAnalyses::Bit(Traits::kind);
+    }
+};
+
+inline std::unique_ptr<LoopAnalyzer> AnalysisTraits<LoopAnalyzer>::Compute(Graph* graph, AnalysisManager& am) {
+    auto loops = std::make_unique<LoopAnalyzer>(graph, &am.Get<DominatorAnalysis>());
+    loops->Run();
+    return loops;
+}
+
+inline std::unique_ptr<LinearOrderBuilder> AnalysisTraits<LinearOrderBuilder>::Compute(Graph* graph, AnalysisManager& am) {
+    auto order = std::make_unique<LinearOrderBuilder>(graph, &am.Get<LoopAnalyzer>());
+    order->Run();
+    return order;
+}
+
+inline std::unique_ptr<LivenessAnalysis> AnalysisTraits<LivenessAnalysis>::Compute(Graph* graph, AnalysisManager& am) {
+    auto liveness = std::make_unique<LivenessAnalysis>(graph);
+    liveness->SetLinearOrder(am.Get<LinearOrderBuilder>().GetLinearOrder());
+    liveness->Run();
+    return liveness;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Backing storage for everything a Graph creates (instructions, blocks).
+// The Graph picks the implementation at construction time, so the old
+// one-malloc-per-object behaviour stays available as HeapAllocator.
+class GraphAllocator {
+public:
+    virtual ~GraphAllocator() = default;
+
+    virtual void* Allocate(size_t size, size_t align) = 0;
+    virtual void Deallocate(void* ptr, size_t size, size_t align) = 0;
+
+    // true if destroying the allocator itself reclaims every object, so the
+    // owner may skip per-object Deallocate calls on teardown
+    virtual bool ReleasesOnDestruction() const = 0;
+
+    size_t GetAllocationCount() const { return allocation_count_; }
+    size_t GetSystemAllocationCount() const { return system_allocation_count_; }
+
+protected:
+    size_t allocation_count_ = 0;
+    size_t system_allocation_count_ = 0;
+};
+
+class HeapAllocator : public GraphAllocator {
+public:
+    void* Allocate(size_t size, size_t align) override {
+        allocation_count_++;
+        system_allocation_count_++;
+        return ::operator new(size, std::align_val_t(align));
+    }
+
+    void Deallocate(void* ptr, size_t size, size_t align) override {
+        ::operator delete(ptr, size, std::align_val_t(align));
+    }
+
+    bool ReleasesOnDestruction() const override { return false; }
+};
+
+// Bump-pointer allocator over fixed-size chunks. Freed objects go to a free
+// list per size class and are reused by the next allocation of that class;
+// the chunks themselves are only returned when the arena dies.
+class ArenaAllocator : public GraphAllocator {
+public:
+    static constexpr size_t kChunkSize = 64 * 1024;
+    static constexpr size_t kGranule = alignof(std::max_align_t);
+    static constexpr size_t kNumSizeClasses = 32;
+
+    ArenaAllocator() = default;
+    ArenaAllocator(const ArenaAllocator&) = delete;
+    ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+    void* Allocate(size_t size, size_t align) override {
+        assert(align <= kGranule && "over-aligned types are not supported");
+        (void)align;
+        allocation_count_++;
+
+        size_t rounded = RoundUp(size);
+        size_t size_class = rounded / kGranule;
+        if (size_class < kNumSizeClasses && free_lists_[size_class]) {
+            FreeNode* node = free_lists_[size_class];
+            free_lists_[size_class] = node->next;
+            return node;
+        }
+
+        if (rounded > static_cast<size_t>(end_ - cur_)) {
+            NewChunk(rounded);
+        }
+        void* result = cur_;
+        cur_ += rounded;
+        return result;
+    }
+
+    void Deallocate(void* ptr, size_t size, size_t align) override {
+        (void)align;
+        size_t size_class = RoundUp(size) / kGranule;
+        if (!ptr || size_class >= kNumSizeClasses) return;
+        auto* node = static_cast<FreeNode*>(ptr);
+        node->next = free_lists_[size_class];
+        free_lists_[size_class] = node;
+    }
+
+    bool ReleasesOnDestruction() const override { return true; }
+
+    size_t GetChunkCount() const { return chunks_.size(); }
+
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    std::vector<std::unique_ptr<std::byte[]>> chunks_;
+    std::array<FreeNode*, kNumSizeClasses> free_lists_ {};
+    std::byte* cur_ = nullptr;
+    std::byte* end_ = nullptr;
+
+    static size_t RoundUp(size_t size) {
+        if (size < sizeof(FreeNode)) size = sizeof(FreeNode);
+        return (size + kGranule - 1) & ~(kGranule - 1);
+    }
+
+    void NewChunk(size_t min_size) {
+        size_t size = min_size > kChunkSize ? min_size : kChunkSize;
+        chunks_.emplace_back(new std::byte[size]);
+        system_allocation_count_++;
+        cur_ = chunks_.back().get();
+        end_ = cur_ + size;
+    }
+};
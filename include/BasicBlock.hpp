@@ -8,26 +8,22 @@
 class Graph;
 
 class BasicBlock {
+public:
+    using BlockList = SmallVector<BasicBlock*, 2>;
+
 private:
     Graph* graph_;
     int id_;
-    std::vector<BasicBlock*> preds_;
-    std::vector<BasicBlock*> succs_;
+    BlockList preds_;
+    BlockList succs_;
 
     Instruction* first_phi_ = nullptr;
     Instruction* last_phi_ = nullptr;
     Instruction* first_inst_ = nullptr;
     Instruction* last_inst_ = nullptr;
 public:
+    // instructions are owned and released by the Graph
     explicit BasicBlock(Graph* graph, int id) : graph_(graph), id_(id) {}
-    ~BasicBlock() {
-        Instruction* current = first_phi_;
-        while (current) {
-            Instruction* next = current->GetNext();
-            delete current;
-            current = next;
-        }
-    }
     void Dump() const {
         std::cout << "BB<" << GetId() << ">" << std::endl;
         if (!preds_.empty()) {
@@ -49,20 +45,21 @@ public:
             }
         }
     }
-    void AddPred(BasicBlock* pred) { preds_.push_back(pred); }
+    // edge edits invalidate the graph's cached CFG orders (see Graph.hpp)
+    void AddPred(BasicBlock* pred);
     template<typename... Args>
-    void AddSucc(Args*... args) {
-        (succs_.push_back(args), ...);
-    }
+    void AddSucc(Args*... args);
 
     template<typename... Successors>
-    void LinkTo(Successors*... succs) {
-        (succs_.push_back(succs), ...);
-        (succs->AddPred(this), ...);
-    }
+    void LinkTo(Successors*... succs);
+    // Removes one edge to succ, together with the matching phi inputs.
+    void RemoveEdgeTo(BasicBlock* succ);
+    // Redirects the edge to old_succ (and the terminator) to new_succ.
+    // Phi inputs of either block are left to the caller.
+    void ReplaceSucc(BasicBlock* old_succ, BasicBlock* new_succ);
 
-    const std::vector<BasicBlock*>& GetPreds() const { return preds_; }
-    const std::vector<BasicBlock*>& GetSuccs() const { return succs_; }
+    const BlockList& GetPreds() const { return preds_; }
+    const BlockList& GetSuccs() const { return succs_; }
     Graph* GetGraph() const { return graph_; }
     Instruction* GetFirstPhi() const { return first_phi_; }
     Instruction* GetLastPhi() const { return last_phi_; }
@@ -94,6 +91,19 @@ public:
         }
     }
 
+    // pos must be a non-phi instruction of this block
+    void InsertBefore(Instruction* pos, Instruction* inst) {
+        inst->SetBasicBlock(this);
+        inst->SetNext(pos);
+        inst->SetPrev(pos->GetPrev());
+        if (pos->GetPrev()) {
+            pos->GetPrev()->SetNext(inst);
+        } else {
+            first_inst_ = inst;
+        }
+        pos->SetPrev(inst);
+    }
+
     void RemoveInst(Instruction* inst) {
         if (!inst) return;
 
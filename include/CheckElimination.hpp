@@ -2,21 +2,37 @@
 
 #include "Graph.hpp"
 #include "DominatorAnalysis.hpp"
+#include "LoopAnalyzer.hpp"
+#include "PreservedAnalyses.hpp"
 #include <vector>
 #include <algorithm>
 
+class AnalysisManager;
+
+// Drops NullChecks and BoundsChecks repeated under an identical check
+// that dominates them, then BoundsChecks whose index the range analysis
+// proves to be in [0, length). Without a loop analysis one is computed
+// for the range step.
 class CheckElimination {
 public:
-    CheckElimination(Graph* graph, DominatorAnalysis* dom)
-        : graph_(graph), dom_(dom) {}
+    CheckElimination(Graph* graph, DominatorAnalysis* dom, LoopAnalyzer* loops = nullptr)
+        : graph_(graph), dom_(dom), loops_(loops) {}
+    CheckElimination(Graph* graph, AnalysisManager& am);
 
     void Run();
     int GetRemovedCount() const { return removed_count_; }
+    // the part of GetRemovedCount that needed range analysis
+    int GetProvenCount() const { return proven_count_; }
+    PreservedAnalyses GetPreservedAnalyses() const {
+        return removed_count_ ? PreservedAnalyses::CFG() : PreservedAnalyses::All();
+    }
 private:
     Graph* graph_;
     DominatorAnalysis* dom_;
+    LoopAnalyzer* loops_;
     int removed_count_ = 0;
+    int proven_count_ = 0;
 
-    void ReplaceAllUses(Instruction* oldInst, Instruction* newInst);
     void RemoveDominatedChecks();
+    void RemoveProvenChecks();
 };
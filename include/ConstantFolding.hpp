@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <variant>
+#include "Instruction.hpp"
+
+// Integer semantics shared by every pass that evaluates instructions at
+// compile time. Arithmetic wraps at the width of the result type, shift
+// counts are taken modulo that width and Cmp is a signed less-or-equal
+// producing 0 or 1.
+
+inline int64_t GetConstantValue(const ConstantInst* c) {
+    return std::visit([](auto arg) { return static_cast<int64_t>(arg); }, c->GetValue());
+}
+
+inline int64_t WrapToType(Type type, int64_t value) {
+    if (type == Type::int32) return static_cast<int32_t>(static_cast<uint32_t>(value));
+    return value;
+}
+
+inline ConstantInst::ValueType MakeConstantValue(Type type, int64_t value) {
+    if (type == Type::int32) return static_cast<int32_t>(WrapToType(type, value));
+    return value;
+}
+
+inline std::optional<int64_t> FoldBinaryOp(Opcode opcode, Type type, int64_t lhs, int64_t rhs) {
+    auto ulhs = static_cast<uint64_t>(lhs);
+    auto urhs = static_cast<uint64_t>(rhs);
+    int64_t bits = type == Type::int32 ? 32 : 64;
+    switch (opcode) {
+        case Opcode::Add: return WrapToType(type, static_cast<int64_t>(ulhs + urhs));
+        case Opcode::Sub: return WrapToType(type, static_cast<int64_t>(ulhs - urhs));
+        case Opcode::Mul: return WrapToType(type, static_cast<int64_t>(ulhs * urhs));
+        case Opcode::Or:  return WrapToType(type, lhs | rhs);
+        case Opcode::AShr: return WrapToType(type, WrapToType(type, lhs) >> (rhs & (bits - 1)));
+        case Opcode::Shl: return WrapToType(type, static_cast<int64_t>(ulhs << (rhs & (bits - 1))));
+        case Opcode::Cmp: return lhs <= rhs ? 1 : 0;
+        default: return std::nullopt;
+    }
+}
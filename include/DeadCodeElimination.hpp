@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "GraphMaps.hpp"
+#include "PreservedAnalyses.hpp"
+
+// Mark and sweep DCE. Instructions with effects (returns, branches,
+// calls, checks, stores) and parameters are live roots, everything they
+// transitively use is live, and the rest - dead phi cycles included - is
+// unlinked and handed back to the graph allocator together with the
+// blocks the entry can no longer reach.
+class DeadCodeElimination {
+public:
+    explicit DeadCodeElimination(Graph* graph) : graph_(graph) {}
+
+    void Run();
+    size_t GetRemovedCount() const { return removed_count_; }
+    size_t GetRemovedBlockCount() const { return removed_blocks_; }
+    PreservedAnalyses GetPreservedAnalyses() const {
+        if (removed_blocks_) return PreservedAnalyses::None();
+        return removed_count_ ? PreservedAnalyses::CFG() : PreservedAnalyses::All();
+    }
+
+    static bool IsRoot(const Instruction* inst);
+
+private:
+    Graph* graph_;
+    InstMap<bool> live_;
+    size_t removed_count_ = 0;
+    size_t removed_blocks_ = 0;
+
+    void Mark();
+    void Sweep();
+};
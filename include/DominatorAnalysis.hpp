@@ -1,12 +1,15 @@
 #pragma once
-#include <unordered_map>
 #include <vector>
 #include <iomanip>
 #include <sstream>
 #include <iostream>
 #include "BasicBlock.hpp"
 #include "Graph.hpp"
-#include <set>
+#include "GraphMaps.hpp"
+
+// Dominator tree built with the Cooper-Harvey-Kennedy iteration over RPO.
+// Tree nodes carry pre/post DFS numbers, so Dominates() is two compares.
+// Blocks unreachable from the entry are not part of the tree.
 class DominatorAnalysis {
 public:
     explicit DominatorAnalysis(Graph* graph) : graph_(graph) {}
@@ -14,8 +17,18 @@ public:
     void Run();
     BasicBlock* GetIdom(BasicBlock* bb) const;
     bool Dominates(BasicBlock* dom, BasicBlock* node) const;
+    bool IsReachable(const BasicBlock* bb) const { return pre_.Get(bb) >= 0; }
+
+    const std::vector<BasicBlock*>& GetChildren(const BasicBlock* bb) const { return children_.Get(bb); }
+    // reachable blocks in dominator tree pre-order, parents before children
+    const std::vector<BasicBlock*>& GetPreOrder() const { return preorder_; }
 private:
     Graph* graph_;
-    std::unordered_map<BasicBlock*, BasicBlock*> idoms_;
-    std::unordered_map<BasicBlock*, std::set<BasicBlock*>> dominators_;
-};
\ No newline at end of file
+    BlockMap<BasicBlock*> idoms_;
+    BlockMap<std::vector<BasicBlock*>> children_;
+    BlockMap<int> pre_;
+    BlockMap<int> post_;
+    std::vector<BasicBlock*> preorder_;
+
+    void NumberTree(BasicBlock* root);
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "DominatorAnalysis.hpp"
+#include "PreservedAnalyses.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class AnalysisManager;
+
+// Global value numbering of pure instructions (constants and binary
+// operations). Blocks are visited in dominator tree order with a scoped
+// table, so an instruction is replaced only by an equal one that
+// dominates it. Operands of commutative opcodes are ordered by id before
+// hashing.
+class GVN {
+public:
+    GVN(Graph* graph, DominatorAnalysis* dom) : graph_(graph), dom_(dom) {}
+    GVN(Graph* graph, AnalysisManager& am);
+
+    void Run();
+    size_t GetRemovedCount() const { return removed_count_; }
+    PreservedAnalyses GetPreservedAnalyses() const {
+        return removed_count_ ? PreservedAnalyses::CFG() : PreservedAnalyses::All();
+    }
+
+private:
+    struct ValueKey {
+        Opcode opcode;
+        Type type;
+        int64_t constant = 0;
+        const Instruction* lhs = nullptr;
+        const Instruction* rhs = nullptr;
+
+        bool operator==(const ValueKey& other) const {
+            return opcode == other.opcode && type == other.type && constant == other.constant &&
+                   lhs == other.lhs && rhs == other.rhs;
+        }
+    };
+
+    struct ValueKeyHash {
+        size_t operator()(const ValueKey& key) const;
+    };
+
+    Graph* graph_;
+    DominatorAnalysis* dom_;
+    std::unordered_map<ValueKey, Instruction*, ValueKeyHash> table_;
+    size_t removed_count_ = 0;
+
+    static bool MakeKey(const Instruction* inst, ValueKey& key);
+    void VisitBlock(BasicBlock* bb, std::vector<ValueKey>& scope);
+};
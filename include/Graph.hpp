@@ -1,50 +1,172 @@
 #pragma once
 
+#include <cassert>
 #include <memory>
 #include <map>
-#include <list>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <set>
+#include <utility>
+#include "ArenaAllocator.hpp"
 #include "BasicBlock.hpp"
 
 class Graph {
+public:
+    // Blocks live in the graph allocator, so the deleter only runs the
+    // destructor and hands the memory back when the allocator needs it.
+    struct BlockDeleter {
+        GraphAllocator* allocator = nullptr;
+        void operator()(BasicBlock* bb) const {
+            bb->~BasicBlock();
+            if (!allocator->ReleasesOnDestruction()) {
+                allocator->Deallocate(bb, sizeof(BasicBlock), alignof(BasicBlock));
+            }
+        }
+    };
+    using BlockPtr = std::unique_ptr<BasicBlock, BlockDeleter>;
+
 private:
-    std::list<std::unique_ptr<BasicBlock>> blocks_;
+    struct InstSlot {
+        Instruction* inst = nullptr;
+        size_t size = 0;
+        size_t align = 0;
+    };
+
+    // declared first so that it outlives every block and instruction
+    std::unique_ptr<GraphAllocator> allocator_;
+    // in creation order; once blocks are removed a block's id no longer
+    // gives its position here, so side tables index by id instead
+    std::vector<BlockPtr> blocks_;
+    std::vector<InstSlot> instructions_;
     int next_bb_id = 0;
     int next_inst_id_ = 0;
     BasicBlock* entry_block_ = nullptr;
+    // never reused, unlike the address, so per-graph records of a freed
+    // graph can not be mistaken for a later one
+    uint64_t uid_ = next_uid_.fetch_add(1, std::memory_order_relaxed);
+    inline static std::atomic<uint64_t> next_uid_ {0};
+
+    // cached reverse post-order, dropped by every CFG edit
+    std::vector<BasicBlock*> rpo_;
+    bool rpo_valid_ = false;
+
+    void DestroyInstruction(InstSlot& slot, bool teardown) {
+        slot.inst->~Instruction();
+        if (!teardown || !allocator_->ReleasesOnDestruction()) {
+            allocator_->Deallocate(slot.inst, slot.size, slot.align);
+        }
+        slot.inst = nullptr;
+    }
+
 public:
-    Graph() = default;
+    explicit Graph(std::unique_ptr<GraphAllocator> allocator = std::make_unique<ArenaAllocator>())
+        : allocator_(std::move(allocator)) {}
+    Graph(const Graph&) = delete;
+    Graph& operator=(const Graph&) = delete;
+    // Independent copy of the reachable blocks, made by GraphCloner.
+    std::unique_ptr<Graph> Clone();
+    ~Graph() {
+        for (auto& slot : instructions_) {
+            if (slot.inst) DestroyInstruction(slot, true);
+        }
+    }
+
     BasicBlock* CreateNewBasicBlock() {
-        blocks_.emplace_back(std::make_unique<BasicBlock>(this, next_bb_id++));
-        return blocks_.back().get();
+        void* mem = allocator_->Allocate(sizeof(BasicBlock), alignof(BasicBlock));
+        auto* bb = new (mem) BasicBlock(this, next_bb_id++);
+        blocks_.emplace_back(bb, BlockDeleter{allocator_.get()});
+        return bb;
+    }
+
+    // Every instruction of the graph is created here. The graph keeps it
+    // until FreeInstruction or its own destruction.
+    template <typename T, typename... Args>
+    T* CreateInstruction(Args&&... args) {
+        int id = next_inst_id_++;
+        void* mem = allocator_->Allocate(sizeof(T), alignof(T));
+        auto* inst = new (mem) T(id, std::forward<Args>(args)...);
+        auto idx = static_cast<size_t>(id);
+        if (idx >= instructions_.size()) instructions_.resize(idx + 1);
+        instructions_[idx] = {inst, sizeof(T), alignof(T)};
+        return inst;
+    }
+
+    // The instruction must already be unlinked from its block and users.
+    void FreeInstruction(Instruction* inst) {
+        auto idx = static_cast<size_t>(inst->GetId());
+        if (idx < instructions_.size() && instructions_[idx].inst == inst) {
+            DestroyInstruction(instructions_[idx], false);
+        }
     }
+
+    // Frees bb and every instruction in it. The block must already be cut
+    // off from the CFG and its values must be unused outside of it; ids of
+    // the remaining blocks do not change.
+    void RemoveBlock(BasicBlock* bb) { RemoveBlocks({bb}); }
+
+    // RemoveBlock for a batch of blocks that may use each other's values.
+    // blocks_ is compacted once instead of searched per block.
+    void RemoveBlocks(const std::vector<BasicBlock*>& bbs) {
+        if (bbs.empty()) return;
+        std::vector<bool> removed(GetBlockIdBound(), false);
+        for (auto* bb : bbs) {
+            assert(bb != entry_block_ && bb->GetPreds().empty() && bb->GetSuccs().empty());
+            removed[static_cast<size_t>(bb->GetId())] = true;
+            // unlink every block first, so none is freed while still used
+            for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) inst->DropInputs();
+            for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) inst->DropInputs();
+        }
+        for (auto* bb : bbs) FreeBlockInstructions(bb);
+        blocks_.erase(std::remove_if(blocks_.begin(), blocks_.end(),
+            [&removed](const BlockPtr& block) { return removed[static_cast<size_t>(block->GetId())]; }),
+            blocks_.end());
+        InvalidateCFG();
+    }
+
+    // Removes every block the entry cannot reach and returns how many.
+    size_t RemoveUnreachableBlocks() {
+        std::vector<bool> reachable(GetBlockIdBound(), false);
+        for (auto* bb : GetRPO()) reachable[static_cast<size_t>(bb->GetId())] = true;
+
+        std::vector<BasicBlock*> dead;
+        for (auto& block : blocks_) {
+            if (!reachable[static_cast<size_t>(block->GetId())]) dead.push_back(block.get());
+        }
+        for (auto* bb : dead) {
+            while (!bb->GetSuccs().empty()) bb->RemoveEdgeTo(bb->GetSuccs().back());
+            while (!bb->GetPreds().empty()) bb->GetPreds().back()->RemoveEdgeTo(bb);
+        }
+        RemoveBlocks(dead);
+        return dead.size();
+    }
+
+    GraphAllocator* GetAllocator() const { return allocator_.get(); }
+    uint64_t GetUid() const { return uid_; }
+    size_t GetInstructionIdBound() const { return static_cast<size_t>(next_inst_id_); }
+
     int getNextInstructionId() {
         return next_inst_id_++;
     }
     void SetEntryBlock(BasicBlock* bb) {
         entry_block_ = bb;
+        InvalidateCFG();
     }
     BasicBlock* GetEntryBlock() const { return entry_block_; }
-    const std::list<std::unique_ptr<BasicBlock>>& GetBlocks() const { return blocks_; }
-
-    std::vector<BasicBlock*> GetRPO() {
-        std::vector<BasicBlock*> rpo;
-        std::set<BasicBlock*> visited;
-        
-        DFS(entry_block_, visited, rpo);
-        std::reverse(rpo.begin(), rpo.end());
-        return rpo;
-    }
-
-    void DFS(BasicBlock* bb, std::set<BasicBlock*>& visited, std::vector<BasicBlock*>& rpo) {
-        if (!bb || visited.count(bb)) return;
-        visited.insert(bb);
-        for (auto* succ : bb->GetSuccs()) {
-            DFS(succ, visited, rpo);
+    const std::vector<BlockPtr>& GetBlocks() const { return blocks_; }
+    size_t GetBlockIdBound() const { return static_cast<size_t>(next_bb_id); }
+
+    void InvalidateCFG() { rpo_valid_ = false; }
+
+    // Blocks reachable from the entry in reverse post-order. Computed by an
+    // iterative DFS on first request and kept until the CFG changes.
+    const std::vector<BasicBlock*>& GetRPO() {
+        if (!rpo_valid_) {
+            ComputeRPO();
+            rpo_valid_ = true;
         }
-        rpo.push_back(bb);
+        return rpo_;
     }
 
     void Dump() const {
@@ -52,11 +174,96 @@ public:
             block->Dump();
         }
     };
+
+private:
+    // inputs are already dropped by RemoveBlocks
+    void FreeBlockInstructions(BasicBlock* bb) {
+        std::vector<Instruction*> insts;
+        for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) insts.push_back(inst);
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) insts.push_back(inst);
+        for (auto* inst : insts) {
+            bb->RemoveInst(inst);
+            FreeInstruction(inst);
+        }
+    }
+
+    void ComputeRPO() {
+        rpo_.clear();
+        if (!entry_block_) return;
+
+        std::vector<bool> visited(GetBlockIdBound(), false);
+        std::vector<std::pair<BasicBlock*, size_t>> stack;
+        visited[static_cast<size_t>(entry_block_->GetId())] = true;
+        stack.emplace_back(entry_block_, 0);
+
+        while (!stack.empty()) {
+            auto& [bb, next_succ] = stack.back();
+            const auto& succs = bb->GetSuccs();
+            if (next_succ < succs.size()) {
+                BasicBlock* succ = succs[next_succ++];
+                auto idx = static_cast<size_t>(succ->GetId());
+                if (!visited[idx]) {
+                    visited[idx] = true;
+                    stack.emplace_back(succ, 0);
+                }
+            } else {
+                rpo_.push_back(bb);
+                stack.pop_back();
+            }
+        }
+        std::reverse(rpo_.begin(), rpo_.end());
+    }
 };
 
+inline void BasicBlock::AddPred(BasicBlock* pred) {
+    preds_.push_back(pred);
+    graph_->InvalidateCFG();
+}
+
+template<typename... Args>
+void BasicBlock::AddSucc(Args*... args) {
+    (succs_.push_back(args), ...);
+    graph_->InvalidateCFG();
+}
+
+template<typename... Successors>
+void BasicBlock::LinkTo(Successors*... succs) {
+    (succs_.push_back(succs), ...);
+    (succs->AddPred(this), ...);
+    graph_->InvalidateCFG();
+}
+
+inline void BasicBlock::RemoveEdgeTo(BasicBlock* succ) {
+    auto succ_it = std::find(succs_.begin(), succs_.end(), succ);
+    if (succ_it != succs_.end()) succs_.erase(succ_it);
+    auto pred_it = std::find(succ->preds_.begin(), succ->preds_.end(), this);
+    if (pred_it != succ->preds_.end()) succ->preds_.erase(pred_it);
+    for (auto* inst = succ->GetFirstPhi(); inst; inst = inst->GetNext()) {
+        static_cast<PhiInst*>(inst)->RemoveIncomingBlock(this);
+    }
+    graph_->InvalidateCFG();
+}
+
+inline void BasicBlock::ReplaceSucc(BasicBlock* old_succ, BasicBlock* new_succ) {
+    for (auto& succ : succs_) {
+        if (succ == old_succ) succ = new_succ;
+    }
+    auto pred_it = std::find(old_succ->preds_.begin(), old_succ->preds_.end(), this);
+    if (pred_it != old_succ->preds_.end()) old_succ->preds_.erase(pred_it);
+    new_succ->preds_.push_back(this);
+
+    if (auto* jump = dyn_cast<JumpInst>(last_inst_)) {
+        jump->ReplaceTarget(new_succ);
+    } else if (auto* branch = dyn_cast<IfInst>(last_inst_)) {
+        branch->ReplaceTargets(branch->GetTrueTarget() == old_succ ? new_succ : branch->GetTrueTarget(),
+                               branch->GetFalseTarget() == old_succ ? new_succ : branch->GetFalseTarget());
+    }
+    graph_->InvalidateCFG();
+}
 
 inline BasicBlock* BasicBlock::SplitAfter(Instruction* split_point) {   
     BasicBlock* cont_bb = graph_->CreateNewBasicBlock();
+    graph_->InvalidateCFG();
     cont_bb->succs_ = this->succs_;
     this->succs_.clear();
 
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "GraphMaps.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Copies blocks of a source graph into a target graph, which may be the
+// source itself. Copies are recorded in maps indexed by source ids, and
+// operands are translated while each copy is created: blocks go in RPO,
+// so every non-phi operand of the copied region is cloned before its
+// users. Only phi inputs, which may come over back edges, are added once
+// all blocks exist.
+//
+// Values and blocks can be mapped up front (parameters to arguments, a
+// header to the block replacing it). Mapped parameters are used as they
+// are; anything else in the copied blocks is copied again, so the same
+// blocks can be cloned repeatedly, each copy reading the values of the
+// previous one. Constants are shared: one of the same type and value in
+// the target entry block is reused, otherwise the new constant goes to
+// that block, where it dominates every use.
+class GraphCloner {
+public:
+    GraphCloner(Graph* source, Graph* target);
+
+    void Map(const Instruction* from, Instruction* to) { values_[from] = to; }
+    void Map(const BasicBlock* from, BasicBlock* to) { blocks_[from] = to; }
+    // Forgets all copies and mappings.
+    void Reset();
+
+    // Copies blocks, given in RPO. Branch targets inside the set lead to
+    // the copies and edges between copies are linked; targets outside the
+    // set stay as they are and are linked only with link_exits. Incoming
+    // blocks of phis are translated through every block mapping.
+    void CloneBlocks(const std::vector<BasicBlock*>& blocks, bool link_exits = false);
+    // Copies every reachable block of the source into the empty target and
+    // makes the copy of the source entry its entry.
+    void CloneGraph();
+    // Copy of inst with translated operands, left for the caller to place
+    // in bb. Phis are created without inputs and constants are not shared.
+    Instruction* CloneInstruction(Instruction* inst, BasicBlock* bb);
+
+    Instruction* GetClone(const Instruction* inst) const { return values_.Get(inst); }
+    BasicBlock* GetClone(const BasicBlock* bb) const { return blocks_.Get(bb); }
+    // the copy of value, or value itself when it has none
+    Instruction* Lookup(Instruction* value) const {
+        Instruction* mapped = values_.Get(value);
+        return mapped ? mapped : value;
+    }
+
+private:
+    struct ConstantKey {
+        Type type;
+        int64_t value;
+        bool operator==(const ConstantKey& other) const { return type == other.type && value == other.value; }
+    };
+
+    struct ConstantKeyHash {
+        size_t operator()(const ConstantKey& key) const;
+    };
+
+    Graph* source_;
+    Graph* target_;
+    InstMap<Instruction*> values_;
+    BlockMap<BasicBlock*> blocks_;
+    std::unordered_map<ConstantKey, ConstantInst*, ConstantKeyHash> constants_;
+    bool constants_indexed_ = false;
+
+    void CreateBlocks(const std::vector<BasicBlock*>& blocks);
+    void CopyBlocks(const std::vector<BasicBlock*>& blocks, bool link_exits);
+    Instruction* GetSharedConstant(ConstantInst* constant);
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Graph.hpp"
+
+// Side table indexed directly by the dense id of a block or instruction.
+// Lookups are one array access; reading a node the table has not seen yet
+// yields the default value, writing one grows the table.
+template <typename Node, typename T>
+class IdMap {
+public:
+    using reference = typename std::vector<T>::reference;
+    using const_reference = typename std::vector<T>::const_reference;
+
+    IdMap() = default;
+    explicit IdMap(size_t bound, const T& init = T()) : data_(bound, init), init_(init) {}
+
+    void Reset(size_t bound, const T& init = T()) {
+        init_ = init;
+        data_.assign(bound, init);
+    }
+
+    reference operator[](const Node* node) { return operator[](node->GetId()); }
+    reference operator[](int id) {
+        auto idx = static_cast<size_t>(id);
+        if (idx >= data_.size()) data_.resize(idx + 1, init_);
+        return data_[idx];
+    }
+
+    const_reference Get(const Node* node) const { return Get(node->GetId()); }
+    const_reference Get(int id) const {
+        auto idx = static_cast<size_t>(id);
+        return idx < data_.size() ? data_[idx] : const_reference(init_);
+    }
+
+    size_t size() const { return data_.size(); }
+    std::vector<T>& Values() { return data_; }
+    const std::vector<T>& Values() const { return data_; }
+
+private:
+    std::vector<T> data_;
+    T init_ {};
+};
+
+template <typename T>
+class BlockMap : public IdMap<BasicBlock, T> {
+public:
+    BlockMap() = default;
+    explicit BlockMap(const Graph* graph, const T& init = T())
+        : IdMap<BasicBlock, T>(graph->GetBlockIdBound(), init) {}
+    void Reset(const Graph* graph, const T& init = T()) {
+        IdMap<BasicBlock, T>::Reset(graph->GetBlockIdBound(), init);
+    }
+};
+
+template <typename T>
+class InstMap : public IdMap<Instruction, T> {
+public:
+    InstMap() = default;
+    explicit InstMap(const Graph* graph, const T& init = T())
+        : IdMap<Instruction, T>(graph->GetInstructionIdBound(), init) {}
+    void Reset(const Graph* graph, const T& init = T()) {
+        IdMap<Instruction, T>::Reset(graph->GetInstructionIdBound(), init);
+    }
+};
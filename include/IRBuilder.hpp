@@ -1,21 +1,131 @@
 #pragma once
 
 #include "Graph.hpp"
+#include "GraphMaps.hpp"
 #include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 class IRBuilder {
 private:
     Graph* graph_;
     BasicBlock* current_bb_ = nullptr;
 
+    // SSA construction state (Braun et al., "Simple and Efficient
+    // Construction of Static Single Assignment Form")
+    std::vector<Type> var_types_;
+    std::vector<BlockMap<Instruction*>> current_def_;
+    BlockMap<bool> sealed_;
+    BlockMap<std::vector<std::pair<int, PhiInst*>>> incomplete_phis_;
+    InstMap<int> phi_var_;
+    // trivial phis are unlinked at once but freed only when the public
+    // call returns, since callers up the recursion may still hold them
+    InstMap<Instruction*> replaced_by_;
+    InstMap<bool> filling_;
+    std::vector<PhiInst*> dead_phis_;
+
     void CheckInsertPoint() const {
         if (current_bb_ == nullptr) {
             throw std::runtime_error("IRBuilder: no basic block set for insertion");
         }
     }
 
+    void CheckVariable(int var) const {
+        if (var < 0 || static_cast<size_t>(var) >= var_types_.size()) {
+            throw std::runtime_error("IRBuilder: unknown variable " + std::to_string(var));
+        }
+    }
+
+    BlockMap<Instruction*>& Defs(int var) { return current_def_[static_cast<size_t>(var)]; }
+
+    Instruction* Resolve(Instruction* value) const {
+        while (Instruction* next = replaced_by_.Get(value)) value = next;
+        return value;
+    }
+
+    PhiInst* NewVariablePhi(int var, BasicBlock* bb) {
+        auto* phi = graph_->CreateInstruction<PhiInst>(var_types_[static_cast<size_t>(var)], bb);
+        bb->AppendInst(phi);
+        phi_var_[phi] = var;
+        return phi;
+    }
+
+    Instruction* ReadVariableIn(int var, BasicBlock* bb) {
+        if (Instruction* def = Defs(var).Get(bb)) return def;
+
+        Instruction* value = nullptr;
+        if (!sealed_.Get(bb)) {
+            auto* phi = NewVariablePhi(var, bb);
+            incomplete_phis_[bb].emplace_back(var, phi);
+            value = phi;
+        } else if (bb->GetPreds().size() == 1) {
+            value = ReadVariableIn(var, bb->GetPreds()[0]);
+        } else if (bb->GetPreds().empty()) {
+            throw std::runtime_error("IRBuilder: variable " + std::to_string(var) +
+                " is read before any definition in BB<" + std::to_string(bb->GetId()) + ">");
+        } else {
+            // the phi breaks cycles through loops before its operands are read
+            auto* phi = NewVariablePhi(var, bb);
+            Defs(var)[bb] = phi;
+            value = AddPhiOperands(var, phi);
+        }
+        Defs(var)[bb] = value;
+        return value;
+    }
+
+    Instruction* AddPhiOperands(int var, PhiInst* phi) {
+        filling_[phi] = true;
+        for (auto* pred : phi->GetBasicBlock()->GetPreds()) {
+            phi->AddPhiInput(pred, ReadVariableIn(var, pred));
+        }
+        filling_[phi] = false;
+        return TryRemoveTrivialPhi(phi);
+    }
+
+    Instruction* TryRemoveTrivialPhi(PhiInst* phi) {
+        Instruction* same = nullptr;
+        for (auto* input : phi->GetInputs()) {
+            if (input == same || input == phi) continue;
+            if (same) return phi;
+            same = input;
+        }
+        if (!same) {
+            throw std::runtime_error("IRBuilder: variable " + std::to_string(phi_var_.Get(phi)) +
+                " has no definition reaching BB<" + std::to_string(phi->GetBasicBlock()->GetId()) + ">");
+        }
+
+        std::vector<PhiInst*> phi_users;
+        for (auto* user : phi->GetUsers()) {
+            if (user != phi && user->GetOpcode() == Opcode::Phi) {
+                phi_users.push_back(static_cast<PhiInst*>(user));
+            }
+        }
+        phi->ReplaceAllUsesWith(same);
+        for (auto& def : Defs(phi_var_.Get(phi)).Values()) {
+            if (def == phi) def = same;
+        }
+        phi->GetBasicBlock()->RemoveInst(phi);
+        phi->DropInputs();
+        replaced_by_[phi] = same;
+        dead_phis_.push_back(phi);
+
+        for (auto* user : phi_users) {
+            if (!replaced_by_.Get(user) && !filling_.Get(user)) TryRemoveTrivialPhi(user);
+        }
+        return Resolve(same);
+    }
+
+    void FreeDeadPhis() {
+        for (auto* phi : dead_phis_) {
+            replaced_by_[phi] = nullptr;
+            graph_->FreeInstruction(phi);
+        }
+        dead_phis_.clear();
+    }
+
 public:
-    explicit IRBuilder(Graph* graph) : graph_(graph) {}
+    explicit IRBuilder(Graph* graph) : graph_(graph), sealed_(graph, false) {}
 
     void SetInsertPoint(BasicBlock* bb) {
         current_bb_ = bb;
@@ -23,14 +133,22 @@ public:
 
     ConstantInst* CreateConstant(Type type, ConstantInst::ValueType value) {
         CheckInsertPoint();
-        auto* inst = new ConstantInst(graph_->getNextInstructionId(), type, current_bb_, value);
+        auto* inst = graph_->CreateInstruction<ConstantInst>(type, current_bb_, value);
         current_bb_->AppendInst(inst);
         return inst;
     }
 
     BinaryInst* CreateAdd(Instruction* lhs, Instruction* rhs) {
         CheckInsertPoint();
-        auto* inst = new BinaryInst(graph_->getNextInstructionId(), Opcode::Add, lhs->GetType(), 
+        auto* inst = graph_->CreateInstruction<BinaryInst>(Opcode::Add, lhs->GetType(), 
+            current_bb_, lhs, rhs);
+        current_bb_->AppendInst(inst);
+        return inst;
+    }
+
+    BinaryInst* CreateSub(Instruction* lhs, Instruction* rhs) {
+        CheckInsertPoint();
+        auto* inst = graph_->CreateInstruction<BinaryInst>(Opcode::Sub, lhs->GetType(), 
             current_bb_, lhs, rhs);
         current_bb_->AppendInst(inst);
         return inst;
@@ -38,7 +156,7 @@ public:
 
     BinaryInst* CreateMul(Instruction* lhs, Instruction* rhs) {
         CheckInsertPoint();
-        auto* inst = new BinaryInst(graph_->getNextInstructionId(), Opcode::Mul, lhs->GetType(), 
+        auto* inst = graph_->CreateInstruction<BinaryInst>(Opcode::Mul, lhs->GetType(), 
             current_bb_, lhs, rhs);
         current_bb_->AppendInst(inst);
         return inst;
@@ -46,7 +164,7 @@ public:
     
     BinaryInst* CreateCmp(Instruction* lhs, Instruction* rhs) {
         CheckInsertPoint();
-        auto* inst = new BinaryInst(graph_->getNextInstructionId(), Opcode::Cmp, Type::int32, 
+        auto* inst = graph_->CreateInstruction<BinaryInst>(Opcode::Cmp, Type::int32, 
             current_bb_, lhs, rhs);
         current_bb_->AppendInst(inst);
         return inst;
@@ -54,7 +172,7 @@ public:
     
     JumpInst* CreateJump(BasicBlock* target) {
         CheckInsertPoint();
-        auto* inst = new JumpInst(graph_->getNextInstructionId(), current_bb_, target);
+        auto* inst = graph_->CreateInstruction<JumpInst>(current_bb_, target);
         current_bb_->AppendInst(inst);
         current_bb_->AddSucc(target);
         target->AddPred(current_bb_);
@@ -63,7 +181,7 @@ public:
 
     IfInst* CreateIf(Instruction* cond, BasicBlock* true_target, BasicBlock* false_target) {
         CheckInsertPoint();
-        auto* inst = new IfInst(graph_->getNextInstructionId(), current_bb_, cond, true_target, false_target);
+        auto* inst = graph_->CreateInstruction<IfInst>(current_bb_, cond, true_target, false_target);
         current_bb_->AppendInst(inst);
         current_bb_->AddSucc(true_target);
         current_bb_->AddSucc(false_target);
@@ -74,28 +192,28 @@ public:
     
     PhiInst* CreatePhi(Type type) {
         CheckInsertPoint();
-        auto* inst = new PhiInst(graph_->getNextInstructionId(), type, current_bb_);
+        auto* inst = graph_->CreateInstruction<PhiInst>(type, current_bb_);
         current_bb_->AppendInst(inst);
         return inst;
     }
     
     ReturnInst* CreateReturn(Instruction* value = nullptr) {
         CheckInsertPoint();
-        auto* inst = new ReturnInst(graph_->getNextInstructionId(), current_bb_, value);
+        auto* inst = graph_->CreateInstruction<ReturnInst>(current_bb_, value);
         current_bb_->AppendInst(inst);
         return inst;
     }
 
     ParameterInst* CreateParameter(Type type) {
         CheckInsertPoint();
-        auto* inst = new ParameterInst(graph_->getNextInstructionId(), type, current_bb_);
+        auto* inst = graph_->CreateInstruction<ParameterInst>(type, current_bb_);
         current_bb_->AppendInst(inst);
         return inst;
     }
 
     BinaryInst* CreateOr(Instruction* lhs, Instruction* rhs) {
         CheckInsertPoint();
-        auto* inst = new BinaryInst(graph_->getNextInstructionId(), Opcode::Or, lhs->GetType(),
+        auto* inst = graph_->CreateInstruction<BinaryInst>(Opcode::Or, lhs->GetType(),
             current_bb_, lhs, rhs);
         current_bb_->AppendInst(inst);
         return inst;
@@ -103,7 +221,15 @@ public:
 
     BinaryInst* CreateShr(Instruction* lhs, Instruction* rhs) {
         CheckInsertPoint();
-        auto* inst = new BinaryInst(graph_->getNextInstructionId(), Opcode::AShr, 
+        auto* inst = graph_->CreateInstruction<BinaryInst>(Opcode::AShr, 
+            lhs->GetType(), current_bb_, lhs, rhs);
+        current_bb_->AppendInst(inst);
+        return inst;
+    }
+
+    BinaryInst* CreateShl(Instruction* lhs, Instruction* rhs) {
+        CheckInsertPoint();
+        auto* inst = graph_->CreateInstruction<BinaryInst>(Opcode::Shl, 
             lhs->GetType(), current_bb_, lhs, rhs);
         current_bb_->AppendInst(inst);
         return inst;
@@ -111,39 +237,83 @@ public:
 
     CallInst* CreateCall(Type ret_type, Graph* callee, const std::vector<Instruction*>& args) {
         CheckInsertPoint();
-        auto* inst = new CallInst(graph_->getNextInstructionId(), ret_type, current_bb_, callee, args);
+        auto* inst = graph_->CreateInstruction<CallInst>(ret_type, current_bb_, callee, args);
         current_bb_->AppendInst(inst);
         return inst;
     }
 
     NullCheckInst* CreateNullCheck(Instruction* obj) {
         CheckInsertPoint();
-        auto* inst = new NullCheckInst(graph_->getNextInstructionId(), obj->GetType(), current_bb_, obj);
+        auto* inst = graph_->CreateInstruction<NullCheckInst>(obj->GetType(), current_bb_, obj);
         current_bb_->AppendInst(inst);
         return inst;
     }
 
     BoundsCheckInst* CreateBoundsCheck(Instruction* index, Instruction* length) {
         CheckInsertPoint();
-        auto* inst = new BoundsCheckInst(graph_->getNextInstructionId(), index->GetType(), current_bb_, index, length);
+        auto* inst = graph_->CreateInstruction<BoundsCheckInst>(index->GetType(), current_bb_, index, length);
         current_bb_->AppendInst(inst);
         return inst;
     }
 
     LoadArrayInst* CreateLoadArray(Type elem_type, Instruction* arr, Instruction* index) {
         CheckInsertPoint();
-        auto* inst = new LoadArrayInst(graph_->getNextInstructionId(), elem_type, current_bb_, arr, index);
+        auto* inst = graph_->CreateInstruction<LoadArrayInst>(elem_type, current_bb_, arr, index);
         current_bb_->AppendInst(inst);
         return inst;
     }
 
     StoreArrayInst* CreateStoreArray(Type elem_type, Instruction* arr, Instruction* index, Instruction* value) {
         CheckInsertPoint();
-        auto* inst = new StoreArrayInst(graph_->getNextInstructionId(), elem_type, current_bb_, arr, index, value);
+        auto* inst = graph_->CreateInstruction<StoreArrayInst>(elem_type, current_bb_, arr, index, value);
         current_bb_->AppendInst(inst);
         return inst;
     }
     
+    // Variables are numbered in declaration order. Reads insert the phis
+    // they need and drop trivial ones, yielding pruned minimal SSA as long
+    // as every block is sealed once all of its predecessors are linked.
+    int DeclareVariable(Type type) {
+        var_types_.push_back(type);
+        current_def_.emplace_back(graph_, nullptr);
+        return static_cast<int>(var_types_.size() - 1);
+    }
+
+    void WriteVariable(int var, Instruction* value) {
+        CheckInsertPoint();
+        WriteVariable(var, current_bb_, value);
+    }
+
+    void WriteVariable(int var, BasicBlock* bb, Instruction* value) {
+        CheckVariable(var);
+        Defs(var)[bb] = value;
+    }
+
+    Instruction* ReadVariable(int var) {
+        CheckInsertPoint();
+        return ReadVariable(var, current_bb_);
+    }
+
+    Instruction* ReadVariable(int var, BasicBlock* bb) {
+        CheckVariable(var);
+        Instruction* value = ReadVariableIn(var, bb);
+        FreeDeadPhis();
+        return value;
+    }
+
+    void SealBlock(BasicBlock* bb) {
+        if (sealed_.Get(bb)) return;
+        auto pending = std::move(incomplete_phis_[bb]);
+        incomplete_phis_[bb].clear();
+        for (auto& [var, phi] : pending) {
+            if (!replaced_by_.Get(phi)) AddPhiOperands(var, phi);
+        }
+        sealed_[bb] = true;
+        FreeDeadPhis();
+    }
+
+    bool IsSealed(const BasicBlock* bb) const { return sealed_.Get(bb); }
+
     template<typename... Args>
     void CreateNamedBlocks(std::map<std::string_view, BasicBlock*>& blocks, Args... names) {
         ( (
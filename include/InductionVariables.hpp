@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "GraphMaps.hpp"
+#include "LoopAnalyzer.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Header phi of a loop with a single latch, entering with init and
+// advanced by a constant step: phi = (init, phi + step).
+struct BasicInductionVariable {
+    Loop* loop = nullptr;
+    PhiInst* phi = nullptr;
+    Instruction* init = nullptr;
+    BinaryInst* update = nullptr;
+    int64_t step = 0;
+};
+
+// value == scale * basic->phi + offset on every iteration of basic->loop,
+// with arithmetic wrapping at the width of the phi type
+struct InductionVariable {
+    const BasicInductionVariable* basic = nullptr;
+    int64_t scale = 0;
+    int64_t offset = 0;
+};
+
+// Finds the basic induction variables of every loop and the values inside
+// the loop that are affine functions of them (Add, Mul and Shl by constants).
+class InductionVariableAnalysis {
+public:
+    InductionVariableAnalysis(Graph* graph, LoopAnalyzer* loops) : graph_(graph), loops_(loops) {}
+
+    void Run();
+    // nullptr when inst is not an induction variable
+    const InductionVariable* Get(const Instruction* inst) const {
+        const auto& iv = ivs_.Get(inst);
+        return iv.basic ? &iv : nullptr;
+    }
+    const std::vector<std::unique_ptr<BasicInductionVariable>>& GetBasicVariables() const { return basics_; }
+
+private:
+    Graph* graph_;
+    LoopAnalyzer* loops_;
+    InstMap<InductionVariable> ivs_;
+    std::vector<std::unique_ptr<BasicInductionVariable>> basics_;
+
+    void FindBasicVariables(Loop* loop);
+    void FindDerivedVariable(BinaryInst* bin);
+};
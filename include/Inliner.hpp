@@ -1,133 +1,228 @@
 #pragma once
 #include "Graph.hpp"
 #include "IRBuilder.hpp"
+#include "DominatorAnalysis.hpp"
+#include "GraphCloner.hpp"
+#include "LoopAnalyzer.hpp"
+#include "PreservedAnalyses.hpp"
+#include "SimplifyCFG.hpp"
+#include "Statistics.hpp"
+#include <algorithm>
+#include <iterator>
 #include <map>
+#include <queue>
 
+// Cost-driven inliner. Call sites sit in one worklist ordered by how far
+// their cost stays below their threshold:
+//  - cost is the callee size, less the call itself and a bonus per use of
+//    every parameter that gets a constant argument;
+//  - the threshold starts at SetThreshold and grows with the loop depth of
+//    the call site, so small callees in hot loops go first.
+// A site is inlined if its cost is within the threshold and the callee
+// still fits into the caller's growth budget. Calls cloned from an
+// inlined body join the worklist one level deeper. Nesting stops at
+// SetMaxDepth, and a function already on the chain of inlined callees
+// SetRecursionLimit times is not inlined again; a graph is never inlined
+// into itself.
 class Inliner {
 public:
     explicit Inliner(Graph* caller) : caller_(caller) {}
 
     void Run() {
-        bool changed = true;
-        while (changed) {
-            changed = false;
-            CallInst* call_to_inline = nullptr;
-            for (const auto& bb : caller_->GetBlocks()) {
-                for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
-                    if (inst->GetOpcode() == Opcode::Call) {
-                        call_to_inline = static_cast<CallInst*>(inst);
-                        break;
-                    }
-                }
-                if (call_to_inline) break;
+        PassStatsScope stats(caller_, "Inliner");
+        std::vector<CallInst*> calls;
+        for (const auto& bb : caller_->GetBlocks()) {
+            for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+                if (auto* call = dyn_cast<CallInst>(inst)) calls.push_back(call);
             }
+        }
+        if (!calls.empty()) {
+            DominatorAnalysis dom(caller_);
+            dom.Run();
+            LoopAnalyzer loops(caller_, &dom);
+            loops.Run();
+            for (auto* call : calls) Push(call, loops.GetLoopDepth(call->GetBasicBlock()), 0, {caller_});
+        }
 
-            if (call_to_inline) {
-                InlineCall(call_to_inline);
-                changed = true;
+        while (!worklist_.empty()) {
+            CallSite site = worklist_.top();
+            worklist_.pop();
+            if (!ShouldInline(site)) continue;
+
+            Graph* callee = site.call->GetCallee();
+            const CalleeInfo& info = GetCalleeInfo(callee);
+            std::vector<std::pair<CallInst*, CallInst*>> nested;
+            InlineCall(site.call, nested);
+            budget_used_ += info.size;
+            inlined_count_++;
+            Statistics::Count(caller_, "Inliner", "inlined_calls");
+
+            std::vector<const Graph*> chain = site.chain;
+            chain.push_back(callee);
+            for (auto [original, clone] : nested) {
+                Push(clone, site.loop_depth + info.call_depths.at(original), site.inline_depth + 1, chain);
             }
         }
+        // every call leaves a split continuation and jump-only blocks behind
+        if (inlined_count_ && simplify_cfg_) SimplifyCFG(caller_).Run();
     }
 
-private:
-    Graph* caller_;
+    void SetSimplifyCFG(bool enabled) { simplify_cfg_ = enabled; }
+    void SetThreshold(int64_t threshold) { threshold_ = threshold; }
+    void SetConstantArgBonus(int64_t bonus) { constant_arg_bonus_ = bonus; }
+    void SetGrowthBudget(size_t budget) { growth_budget_ = budget; }
+    void SetMaxDepth(size_t depth) { max_depth_ = depth; }
+    void SetRecursionLimit(size_t limit) { recursion_limit_ = limit; }
+    size_t GetInlinedCount() const { return inlined_count_; }
 
-    void InlineCall(CallInst* call) {
-        Graph* callee = call->GetCallee();
-        BasicBlock* call_block = call->GetBasicBlock();
-        BasicBlock* cont_block = call_block->SplitAfter(call);
-        call_block->RemoveInst(call);
+    // inlining splits blocks and splices in the callee CFG
+    PreservedAnalyses GetPreservedAnalyses() const {
+        return inlined_count_ ? PreservedAnalyses::None() : PreservedAnalyses::All();
+    }
 
-        std::map<BasicBlock*, BasicBlock*> bb_map;
-        std::map<Instruction*, Instruction*> inst_map;
+private:
+    struct CallSite {
+        CallInst* call = nullptr;
+        int64_t cost = 0;
+        int64_t threshold = 0;
+        int loop_depth = 0;
+        // inlined bodies the call was cloned through
+        size_t inline_depth = 0;
+        std::vector<const Graph*> chain;
+        size_t order = 0;
+    };
 
-        int arg_idx = 0;
-        for (auto* inst = callee->GetEntryBlock()->GetFirstInst(); inst; inst = inst->GetNext()) {
-            if (inst->GetOpcode() == Opcode::Param) {
-                inst_map[inst] = call->GetInputs()[arg_idx++];
-            }
+    struct WorseSite {
+        bool operator()(const CallSite& lhs, const CallSite& rhs) const {
+            int64_t lhs_margin = lhs.cost - lhs.threshold;
+            int64_t rhs_margin = rhs.cost - rhs.threshold;
+            return lhs_margin != rhs_margin ? lhs_margin > rhs_margin : lhs.order > rhs.order;
         }
+    };
 
-        IRBuilder builder(caller_);
-        std::vector<ReturnInst*> cloned_returns;
+    struct CalleeInfo {
+        // instructions a copy adds, parameters and constants excluded
+        size_t size = 0;
+        std::vector<size_t> param_uses;
+        std::map<const Instruction*, int> call_depths;
+    };
+
+    static constexpr int kMaxLoopDepthBonus = 3;
+
+    Graph* caller_;
+    bool simplify_cfg_ = true;
+    int64_t threshold_ = 40;
+    int64_t constant_arg_bonus_ = 4;
+    size_t growth_budget_ = 400;
+    size_t max_depth_ = 3;
+    size_t recursion_limit_ = 1;
+    size_t budget_used_ = 0;
+    size_t inlined_count_ = 0;
+    size_t pushed_count_ = 0;
+    std::priority_queue<CallSite, std::vector<CallSite>, WorseSite> worklist_;
+    std::map<const Graph*, CalleeInfo> callee_info_;
 
-        for (const auto& callee_bb_ptr : callee->GetBlocks()) {
-            BasicBlock* callee_bb = callee_bb_ptr.get();
-            BasicBlock* cloned_bb = caller_->CreateNewBasicBlock();
-            bb_map[callee_bb] = cloned_bb;
+    const CalleeInfo& GetCalleeInfo(Graph* callee) {
+        auto it = callee_info_.find(callee);
+        if (it != callee_info_.end()) return it->second;
 
-            for (auto* inst = callee_bb->GetFirstPhi(); inst; inst = inst->GetNext()) {
-                builder.SetInsertPoint(cloned_bb);
-                inst_map[inst] = builder.CreatePhi(inst->GetType());
+        CalleeInfo& info = callee_info_[callee];
+        for (auto* inst = callee->GetEntryBlock()->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (!isa<ParameterInst>(inst)) continue;
+            auto users = inst->GetUsers();
+            info.param_uses.push_back(static_cast<size_t>(std::distance(users.begin(), users.end())));
+        }
+        bool has_calls = false;
+        for (const auto& bb : callee->GetBlocks()) {
+            for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+                if (!isa<ParameterInst>(inst) && !isa<ConstantInst>(inst)) info.size++;
+                has_calls |= isa<CallInst>(inst);
             }
-            for (auto* inst = callee_bb->GetFirstInst(); inst; inst = inst->GetNext()) {
-                if (inst->GetOpcode() == Opcode::Param) continue;
-                
-                builder.SetInsertPoint(cloned_bb);
-                Instruction* cloned_inst = nullptr;
-
-                if (inst->GetOpcode() == Opcode::Const) {
-                    auto* c = static_cast<ConstantInst*>(inst);
-                    builder.SetInsertPoint(caller_->GetEntryBlock());
-                    cloned_inst = builder.CreateConstant(c->GetType(), c->GetValue());
-                } else if (inst->GetOpcode() == Opcode::Add) {
-                    cloned_inst = builder.CreateAdd(inst->GetInputs()[0], inst->GetInputs()[1]);
-                } else if (inst->GetOpcode() == Opcode::Mul) {
-                    cloned_inst = builder.CreateMul(inst->GetInputs()[0], inst->GetInputs()[1]);
-                } else if (inst->GetOpcode() == Opcode::Cmp) {
-                    cloned_inst = builder.CreateCmp(inst->GetInputs()[0], inst->GetInputs()[1]);
-                } else if (inst->GetOpcode() == Opcode::Jump) {
-                    auto* j = static_cast<JumpInst*>(inst);
-                    cloned_inst = new JumpInst(caller_->getNextInstructionId(), cloned_bb, j->GetTarget());
-                    cloned_bb->AppendInst(cloned_inst);
-                } else if (inst->GetOpcode() == Opcode::If) {
-                    auto* iff = static_cast<IfInst*>(inst);
-                    cloned_inst = new IfInst(caller_->getNextInstructionId(), 
-                    cloned_bb, iff->GetInputs()[0], iff->GetTrueTarget(),
-                    iff->GetFalseTarget());
-                    cloned_bb->AppendInst(cloned_inst);
-                } else if (inst->GetOpcode() == Opcode::Ret) {
-                    Instruction* ret_val = inst->GetInputs().empty() ? nullptr : inst->GetInputs()[0];
-                    cloned_inst = builder.CreateReturn(ret_val);
-                    cloned_returns.push_back(static_cast<ReturnInst*>(cloned_inst));
-                }
-                
-                if (cloned_inst) {
-                    inst_map[inst] = cloned_inst;
+        }
+        if (has_calls) {
+            DominatorAnalysis dom(callee);
+            dom.Run();
+            LoopAnalyzer loops(callee, &dom);
+            loops.Run();
+            for (const auto& bb : callee->GetBlocks()) {
+                for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+                    if (isa<CallInst>(inst)) info.call_depths[inst] = loops.GetLoopDepth(bb.get());
                 }
             }
         }
+        return info;
+    }
 
-        for (const auto& [old_inst, new_inst] : inst_map) {
-            if (old_inst->GetOpcode() == Opcode::Param) continue; 
-            if (new_inst->GetOpcode() == Opcode::Const) continue;
-            for (size_t i = 0; i < new_inst->GetInputs().size(); ++i) {
-                Instruction* old_in = new_inst->GetInputs()[i];
-                if (inst_map.count(old_in)) {
-                    new_inst->ReplaceInput(old_in, inst_map[old_in]);
-                }
-            }
+    void Push(CallInst* call, int loop_depth, size_t inline_depth, std::vector<const Graph*> chain) {
+        const CalleeInfo& info = GetCalleeInfo(call->GetCallee());
+        CallSite site;
+        site.call = call;
+        site.loop_depth = loop_depth;
+        site.inline_depth = inline_depth;
+        site.chain = std::move(chain);
+        site.order = pushed_count_++;
 
-            if (auto* jmp = dynamic_cast<JumpInst*>(new_inst)) {
-                jmp->ReplaceTarget(bb_map[jmp->GetTarget()]);
-            } else if (auto* iff = dynamic_cast<IfInst*>(new_inst)) {
-                iff->ReplaceTargets(bb_map[iff->GetTrueTarget()], bb_map[iff->GetFalseTarget()]);
-            } else if (auto* phi = dynamic_cast<PhiInst*>(new_inst)) {
-                auto* old_phi = static_cast<PhiInst*>(old_inst);
-                for (const auto& pair : old_phi->GetPhiInputs()) {
-                    phi->AddPhiInput(bb_map[pair.first], inst_map[pair.second]);
-                }
+        site.cost = static_cast<int64_t>(info.size) - 1 - static_cast<int64_t>(call->GetInputs().size());
+        for (size_t i = 0; i < call->GetInputs().size() && i < info.param_uses.size(); ++i) {
+            if (isa<ConstantInst>(call->GetInput(i))) {
+                site.cost -= constant_arg_bonus_ * static_cast<int64_t>(info.param_uses[i]);
             }
         }
+        site.threshold = threshold_ * (1 + std::min(loop_depth, kMaxLoopDepthBonus));
+        worklist_.push(std::move(site));
+    }
+
+    bool ShouldInline(const CallSite& site) {
+        Graph* callee = site.call->GetCallee();
+        auto on_chain = static_cast<size_t>(std::count(site.chain.begin(), site.chain.end(), callee));
+        if (callee == caller_ || on_chain >= recursion_limit_) {
+            Statistics::Count(caller_, "Inliner", "rejected_recursion");
+            return false;
+        }
+        if (site.inline_depth >= max_depth_) {
+            Statistics::Count(caller_, "Inliner", "rejected_depth");
+            return false;
+        }
+        if (site.cost > site.threshold) {
+            Statistics::Count(caller_, "Inliner", "rejected_cost");
+            return false;
+        }
+        if (budget_used_ + GetCalleeInfo(callee).size > growth_budget_) {
+            Statistics::Count(caller_, "Inliner", "rejected_budget");
+            return false;
+        }
+        return true;
+    }
 
-        for (const auto&[old_bb, new_bb] : bb_map) {
-            for (auto* succ : old_bb->GetSuccs()) {
-                new_bb->AddSucc(bb_map[succ]);
-                bb_map[succ]->AddPred(new_bb);
+    // Fills nested with the calls of the callee and their copies.
+    void InlineCall(CallInst* call, std::vector<std::pair<CallInst*, CallInst*>>& nested) {
+        Graph* callee = call->GetCallee();
+        BasicBlock* call_block = call->GetBasicBlock();
+        BasicBlock* cont_block = call_block->SplitAfter(call);
+        call_block->RemoveInst(call);
+
+        GraphCloner cloner(callee, caller_);
+        size_t arg_idx = 0;
+        for (auto* inst = callee->GetEntryBlock()->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (inst->GetOpcode() == Opcode::Param) cloner.Map(inst, call->GetInputs()[arg_idx++]);
+        }
+        const auto& rpo = callee->GetRPO();
+        std::vector<BasicBlock*> callee_blocks(rpo.begin(), rpo.end());
+        cloner.CloneBlocks(callee_blocks);
+
+        std::vector<ReturnInst*> cloned_returns;
+        for (auto* callee_bb : callee_blocks) {
+            for (auto* inst = callee_bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+                if (auto* original = dyn_cast<CallInst>(inst)) {
+                    nested.emplace_back(original, cast<CallInst>(cloner.GetClone(original)));
+                } else if (isa<ReturnInst>(inst)) {
+                    cloned_returns.push_back(cast<ReturnInst>(cloner.GetClone(inst)));
+                }
             }
         }
 
-        BasicBlock* callee_entry = bb_map[callee->GetEntryBlock()];
+        IRBuilder builder(caller_);
+        BasicBlock* callee_entry = cloner.GetClone(callee->GetEntryBlock());
         builder.SetInsertPoint(call_block);
         builder.CreateJump(callee_entry);
 
@@ -136,11 +231,12 @@ private:
             Instruction* ret_val = cloned_returns[0]->GetInputs().empty() ? nullptr : cloned_returns[0]->GetInputs()[0];
             
             ret_bb->RemoveInst(cloned_returns[0]);
+            Erase(cloned_returns[0]);
             
             builder.SetInsertPoint(ret_bb);
             builder.CreateJump(cont_block);
             
-            ReplaceAllUses(call, ret_val);
+            if (ret_val) call->ReplaceAllUsesWith(ret_val);
         } else if (cloned_returns.size() > 1) {
             builder.SetInsertPoint(cont_block);
             auto* phi = builder.CreatePhi(call->GetType());
@@ -151,23 +247,18 @@ private:
                 
                 phi->AddPhiInput(ret_bb, ret_val);
                 ret_bb->RemoveInst(ret);
+                Erase(ret);
                 
                 builder.SetInsertPoint(ret_bb);
                 builder.CreateJump(cont_block);
             }
-            ReplaceAllUses(call, phi);
+            call->ReplaceAllUsesWith(phi);
         }
+        Erase(call);
     }
 
-    void ReplaceAllUses(Instruction* oldInst, Instruction* newInst) {
-        if (!oldInst || !newInst) return;
-        for (auto& bb_ptr : caller_->GetBlocks()) {
-            for (Instruction* inst = bb_ptr->GetFirstInst(); inst; inst = inst->GetNext()) {
-                inst->ReplaceInput(oldInst, newInst);
-            }
-            for (Instruction* inst = bb_ptr->GetFirstPhi(); inst; inst = inst->GetNext()) {
-                inst->ReplaceInput(oldInst, newInst);
-            }
-        }
+    void Erase(Instruction* inst) {
+        inst->DropInputs();
+        caller_->FreeInstruction(inst);
     }
 };
\ No newline at end of file
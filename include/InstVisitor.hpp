@@ -0,0 +1,58 @@
+#pragma once
+#include "Instruction.hpp"
+
+// Static visitor over instructions. Derived classes override the Visit*
+// hooks they care about; dispatch is a single switch on the opcode and
+// falls back from the opcode hook to its class hook (VisitAdd ->
+// VisitBinary) and finally to VisitInstruction.
+template <typename Derived, typename RetT = void>
+class InstVisitor {
+public:
+    RetT Visit(Instruction* inst) {
+        switch (inst->GetOpcode()) {
+            case Opcode::Param: return Self()->VisitParam(static_cast<ParameterInst*>(inst));
+            case Opcode::Const: return Self()->VisitConst(static_cast<ConstantInst*>(inst));
+            case Opcode::Add: return Self()->VisitAdd(static_cast<BinaryInst*>(inst));
+            case Opcode::Sub: return Self()->VisitSub(static_cast<BinaryInst*>(inst));
+            case Opcode::Mul: return Self()->VisitMul(static_cast<BinaryInst*>(inst));
+            case Opcode::Cmp: return Self()->VisitCmp(static_cast<BinaryInst*>(inst));
+            case Opcode::Or: return Self()->VisitOr(static_cast<BinaryInst*>(inst));
+            case Opcode::AShr: return Self()->VisitAShr(static_cast<BinaryInst*>(inst));
+            case Opcode::Shl: return Self()->VisitShl(static_cast<BinaryInst*>(inst));
+            case Opcode::Jump: return Self()->VisitJump(static_cast<JumpInst*>(inst));
+            case Opcode::If: return Self()->VisitIf(static_cast<IfInst*>(inst));
+            case Opcode::Phi: return Self()->VisitPhi(static_cast<PhiInst*>(inst));
+            case Opcode::Ret: return Self()->VisitReturn(static_cast<ReturnInst*>(inst));
+            case Opcode::Call: return Self()->VisitCall(static_cast<CallInst*>(inst));
+            case Opcode::NullCheck: return Self()->VisitNullCheck(static_cast<NullCheckInst*>(inst));
+            case Opcode::BoundsCheck: return Self()->VisitBoundsCheck(static_cast<BoundsCheckInst*>(inst));
+            case Opcode::LoadArray: return Self()->VisitLoadArray(static_cast<LoadArrayInst*>(inst));
+            case Opcode::StoreArray: return Self()->VisitStoreArray(static_cast<StoreArrayInst*>(inst));
+            default: return Self()->VisitInstruction(inst);
+        }
+    }
+
+    RetT VisitParam(ParameterInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitConst(ConstantInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitAdd(BinaryInst* inst) { return Self()->VisitBinary(inst); }
+    RetT VisitSub(BinaryInst* inst) { return Self()->VisitBinary(inst); }
+    RetT VisitMul(BinaryInst* inst) { return Self()->VisitBinary(inst); }
+    RetT VisitCmp(BinaryInst* inst) { return Self()->VisitBinary(inst); }
+    RetT VisitOr(BinaryInst* inst) { return Self()->VisitBinary(inst); }
+    RetT VisitAShr(BinaryInst* inst) { return Self()->VisitBinary(inst); }
+    RetT VisitShl(BinaryInst* inst) { return Self()->VisitBinary(inst); }
+    RetT VisitBinary(BinaryInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitJump(JumpInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitIf(IfInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitPhi(PhiInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitReturn(ReturnInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitCall(CallInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitNullCheck(NullCheckInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitBoundsCheck(BoundsCheckInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitLoadArray(LoadArrayInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitStoreArray(StoreArrayInst* inst) { return Self()->VisitInstruction(inst); }
+    RetT VisitInstruction(Instruction*) { return RetT(); }
+
+private:
+    Derived* Self() { return static_cast<Derived*>(this); }
+};
@@ -1,22 +1,130 @@
 #pragma once
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <utility>
 #include <vector>
 #include <variant>
+#include "SmallVector.hpp"
 #include <iostream>
 
 class BasicBlock;
 class Graph;
 
 enum class Opcode {
-    Param, Const, Add, Mul, Cmp, Jump, If, Mov, Phi,
+    Param, Const, Add, Sub, Mul, Cmp, Jump, If, Mov, Phi,
     BrCond, Br, Ret,
-    Or, AShr, Call,
+    Or, AShr, Shl, Call,
     NullCheck, BoundsCheck, LoadArray, StoreArray
 };
 
+inline bool IsBinaryOpcode(Opcode opcode) {
+    switch (opcode) {
+        case Opcode::Add: case Opcode::Sub: case Opcode::Mul: case Opcode::Cmp:
+        case Opcode::Or: case Opcode::AShr: case Opcode::Shl:
+            return true;
+        default:
+            return false;
+    }
+}
+
 enum class Type {
     Unknown, int32, int64
 };
 
+class Instruction;
+
+// One operand slot of an instruction. Each Use is linked into the
+// intrusive user list of the value it refers to, so a def knows all of its
+// uses without any side containers and a use can be detached in O(1).
+// The operand index is the position of the Use in the user's operand array.
+class Use {
+public:
+    explicit Use(Instruction* user) : user_(user) {}
+
+    Instruction* Get() const { return value_; }
+    Instruction* GetUser() const { return user_; }
+    inline unsigned GetOperandIndex() const;
+    Use* GetNext() const { return next_; }
+
+    inline void Set(Instruction* value);
+
+private:
+    friend class Instruction;
+
+    Instruction* value_ = nullptr;
+    Instruction* user_;
+    Use* prev_ = nullptr;
+    Use* next_ = nullptr;
+
+    inline void Link();
+    inline void Unlink();
+};
+
+// Read-only view over an operand array, yields the used values.
+class OperandRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Instruction*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Instruction* const*;
+        using reference = Instruction*;
+
+        explicit iterator(const Use* use) : use_(use) {}
+        Instruction* operator*() const { return use_->Get(); }
+        iterator& operator++() { ++use_; return *this; }
+        bool operator==(const iterator& other) const { return use_ == other.use_; }
+        bool operator!=(const iterator& other) const { return use_ != other.use_; }
+    private:
+        const Use* use_;
+    };
+
+    OperandRange(const Use* begin, const Use* end) : begin_(begin), end_(end) {}
+
+    iterator begin() const { return iterator(begin_); }
+    iterator end() const { return iterator(end_); }
+    size_t size() const { return static_cast<size_t>(end_ - begin_); }
+    bool empty() const { return begin_ == end_; }
+    Instruction* operator[](size_t i) const { return begin_[i].Get(); }
+
+private:
+    const Use* begin_;
+    const Use* end_;
+};
+
+// View over the intrusive use list of a value, yields the users. A user
+// that consumes the value in several operands is listed once per operand.
+class UserRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Instruction*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Instruction* const*;
+        using reference = Instruction*;
+
+        explicit iterator(const Use* use) : use_(use) {}
+        Instruction* operator*() const { return use_->GetUser(); }
+        iterator& operator++() { use_ = use_->GetNext(); return *this; }
+        bool operator==(const iterator& other) const { return use_ == other.use_; }
+        bool operator!=(const iterator& other) const { return use_ != other.use_; }
+    private:
+        const Use* use_;
+    };
+
+    explicit UserRange(const Use* first) : first_(first) {}
+
+    iterator begin() const { return iterator(first_); }
+    iterator end() const { return iterator(nullptr); }
+    bool empty() const { return first_ == nullptr; }
+
+private:
+    const Use* first_;
+};
+
 class Instruction {
 protected:
     int id_;
@@ -26,8 +134,8 @@ protected:
     BasicBlock* basic_block_ = nullptr;
     Instruction* prev_ = nullptr;
     Instruction* next_ = nullptr;
-    std::vector<Instruction*> inputs_;
-    std::vector<Instruction*> users_;
+    SmallVector<Use, 3> inputs_;
+    Use* first_use_ = nullptr;
 
 public:
     Opcode GetOpcode() const { return opcode_; }
@@ -36,27 +144,34 @@ public:
     void SetLifePosition(int pos) { life_position_ = pos; }
     int GetLifePosition() const { return life_position_; }
     BasicBlock* GetBasicBlock() const { return basic_block_; }
-    const std::vector<Instruction*>& GetInputs() const { return inputs_; }
-    const std::vector<Instruction*>& GetUsers() const { return users_; }
+    OperandRange GetInputs() const { return {inputs_.data(), inputs_.data() + inputs_.size()}; }
+    Instruction* GetInput(size_t i) const { return inputs_[i].Get(); }
+    UserRange GetUsers() const { return UserRange(first_use_); }
+    Use* GetFirstUse() const { return first_use_; }
+    bool HasUsers() const { return first_use_ != nullptr; }
 
     void AddInput(Instruction* input) {
-        inputs_.push_back(input);
-        if (input) {
-            input->AddUser(this);
+        if (inputs_.size() == inputs_.capacity()) {
+            GrowInputs();
         }
+        inputs_.emplace_back(this);
+        inputs_.back().Set(input);
     }
 
-    void AddUser(Instruction* user) {
-        users_.push_back(user);
+    void SetInput(size_t i, Instruction* input) { inputs_[i].Set(input); }
+
+    // Erases operand i; later operands shift down by one.
+    void RemoveInput(size_t i) {
+        for (size_t j = i; j < inputs_.size(); ++j) inputs_[j].Unlink();
+        inputs_[i].value_ = nullptr;
+        inputs_.erase(inputs_.begin() + i);
+        for (size_t j = i; j < inputs_.size(); ++j) inputs_[j].Link();
     }
 
-    void RemoveUser(Instruction* user) {
-        for (auto it = users_.begin(); it != users_.end(); ++it) {
-            if (*it == user) {
-                users_.erase(it);
-                break;
-            }
-        }
+    // Detaches every operand from its def; used before the instruction is
+    // freed so that no user list keeps pointing at it.
+    void DropInputs() {
+        for (auto& use : inputs_) use.Set(nullptr);
     }
 
     void SetBasicBlock(BasicBlock* bb) { basic_block_ = bb; }
@@ -68,23 +183,75 @@ public:
 
     Instruction(int id, Opcode opcode, Type type, BasicBlock* bb)
         : id_(id), opcode_(opcode), type_(type), basic_block_(bb) {}
+    Instruction(const Instruction&) = delete;
+    Instruction& operator=(const Instruction&) = delete;
     virtual ~Instruction() = default;
 
+    static bool classof(const Instruction*) { return true; }
+
     virtual void Dump() const = 0;
 
-    virtual void ReplaceInput(Instruction* oldInst, Instruction* newInst) {
-        for (auto& input : inputs_) {
-            if (input == oldInst) {
-                if (oldInst) oldInst->RemoveUser(this);
-                input = newInst;
-                if (newInst) newInst->AddUser(this);
-            }
+    void ReplaceInput(Instruction* oldInst, Instruction* newInst) {
+        for (auto& use : inputs_) {
+            if (use.Get() == oldInst) use.Set(newInst);
         }
     }
+
+    // Rewrites every use of this value to new_inst. Only the actual uses
+    // are touched, each in O(1).
+    void ReplaceAllUsesWith(Instruction* new_inst) {
+        if (new_inst == this) return;
+        while (first_use_) {
+            first_use_->Set(new_inst);
+        }
+    }
+
+private:
+    friend class Use;
+
+    // Uses are linked by address, so a reallocation of the operand array
+    // has to take them out of their lists and put them back afterwards.
+    void GrowInputs() {
+        for (auto& use : inputs_) use.Unlink();
+        inputs_.reserve(inputs_.empty() ? 2 : inputs_.capacity() * 2);
+        for (auto& use : inputs_) use.Link();
+    }
 };
 
+inline unsigned Use::GetOperandIndex() const {
+    return static_cast<unsigned>(this - user_->inputs_.data());
+}
+
+inline void Use::Set(Instruction* value) {
+    if (value_ == value) return;
+    Unlink();
+    value_ = value;
+    Link();
+}
+
+inline void Use::Link() {
+    if (!value_) return;
+    prev_ = nullptr;
+    next_ = value_->first_use_;
+    if (next_) next_->prev_ = this;
+    value_->first_use_ = this;
+}
+
+inline void Use::Unlink() {
+    if (!value_) return;
+    if (prev_) {
+        prev_->next_ = next_;
+    } else {
+        value_->first_use_ = next_;
+    }
+    if (next_) next_->prev_ = prev_;
+    prev_ = nullptr;
+    next_ = nullptr;
+}
+
 class BinaryInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return IsBinaryOpcode(inst->GetOpcode()); }
     BinaryInst(int id, Opcode opcode, Type type, BasicBlock* bb, Instruction* lhs, Instruction* rhs)
         : Instruction(id, opcode, type, bb) {
         AddInput(lhs);
@@ -96,6 +263,7 @@ public:
 class ConstantInst : public Instruction {
 public:
     using ValueType = std::variant<int32_t, int64_t>;
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::Const; }
 
     ConstantInst(int id, Type type, BasicBlock* bb, ValueType value)
         : Instruction(id, Opcode::Const, type, bb), value_(value) {}
@@ -108,6 +276,7 @@ private:
 
 class ReturnInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::Ret; }
     ReturnInst(int id, BasicBlock* bb, Instruction* value)
         : Instruction(id, Opcode::Ret, Type::Unknown, bb) {
         if (value) {
@@ -119,6 +288,7 @@ public:
 
 class ParameterInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::Param; }
     ParameterInst(int id, Type type, BasicBlock* bb) 
         : Instruction(id, Opcode::Param, type, bb) {}
     
@@ -127,6 +297,7 @@ public:
 
 class JumpInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::Jump; }
     JumpInst(int id, BasicBlock* bb, BasicBlock* target)
         : Instruction(id, Opcode::Jump, Type::Unknown, bb), target_(target) {}
     
@@ -140,6 +311,7 @@ private:
 
 class IfInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::If; }
     IfInst(int id, BasicBlock* bb, Instruction* cond, BasicBlock* true_target, BasicBlock* false_target)
         : Instruction(id, Opcode::If, Type::Unknown, bb), true_target_(true_target), false_target_(false_target) {
         AddInput(cond);
@@ -157,38 +329,79 @@ private:
 
 class PhiInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::Phi; }
     PhiInst(int id, Type type, BasicBlock* bb)
         : Instruction(id, Opcode::Phi, type, bb) {}
-    
+
+    // (incoming block, value) pairs; the value of pair i is operand i
+    class PhiInputRange {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<BasicBlock*, Instruction*>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type*;
+            using reference = value_type;
+
+            iterator(const PhiInst* phi, size_t i) : phi_(phi), i_(i) {}
+            value_type operator*() const { return {phi_->blocks_[i_], phi_->GetInput(i_)}; }
+            iterator& operator++() { ++i_; return *this; }
+            bool operator==(const iterator& other) const { return i_ == other.i_; }
+            bool operator!=(const iterator& other) const { return i_ != other.i_; }
+        private:
+            const PhiInst* phi_;
+            size_t i_;
+        };
+
+        explicit PhiInputRange(const PhiInst* phi) : phi_(phi) {}
+        iterator begin() const { return iterator(phi_, 0); }
+        iterator end() const { return iterator(phi_, phi_->blocks_.size()); }
+        size_t size() const { return phi_->blocks_.size(); }
+        bool empty() const { return phi_->blocks_.empty(); }
+        std::pair<BasicBlock*, Instruction*> operator[](size_t i) const { return *iterator(phi_, i); }
+    private:
+        const PhiInst* phi_;
+    };
+
     void AddPhiInput(BasicBlock* from, Instruction* value) {
-        phi_inputs_.emplace_back(from, value);
+        blocks_.push_back(from);
         AddInput(value);
     }
 
-    const std::vector<std::pair<BasicBlock*, Instruction*>>& GetPhiInputs() const {
-        return phi_inputs_;
-    }
+    PhiInputRange GetPhiInputs() const { return PhiInputRange(this); }
+    BasicBlock* GetIncomingBlock(size_t i) const { return blocks_[i]; }
 
     void Dump() const override; 
 
-    void ReplaceInput(Instruction* oldInst, Instruction* newInst) override {
-        Instruction::ReplaceInput(oldInst, newInst);
-        for (auto& pair : phi_inputs_) {
-            if (pair.second == oldInst) pair.second = newInst;
+    void RemovePhiInput(size_t i) {
+        blocks_.erase(blocks_.begin() + i);
+        RemoveInput(i);
+    }
+
+    // drops the first input coming from bb, if any
+    void RemoveIncomingBlock(BasicBlock* bb) {
+        for (size_t i = 0; i < blocks_.size(); ++i) {
+            if (blocks_[i] == bb) {
+                RemovePhiInput(i);
+                return;
+            }
         }
     }
+
     void ReplaceBlock(BasicBlock* old_bb, BasicBlock* new_bb) {
-        for (auto& pair : phi_inputs_) {
-            if (pair.first == old_bb) pair.first = new_bb;
+        for (auto& bb : blocks_) {
+            if (bb == old_bb) bb = new_bb;
         }
     }
 
 private:
-    std::vector<std::pair<BasicBlock*, Instruction*>> phi_inputs_;
+    SmallVector<BasicBlock*, 2> blocks_;
 };
 
 class NullCheckInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::NullCheck; }
     NullCheckInst(int id, Type type, BasicBlock* bb, Instruction* obj)
         : Instruction(id, Opcode::NullCheck, type, bb) {
         AddInput(obj);
@@ -199,6 +412,7 @@ public:
 
 class BoundsCheckInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::BoundsCheck; }
     BoundsCheckInst(int id, Type type, BasicBlock* bb,
                     Instruction* index, Instruction* length)
         : Instruction(id, Opcode::BoundsCheck, type, bb) {
@@ -212,6 +426,7 @@ public:
 
 class LoadArrayInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::LoadArray; }
     LoadArrayInst(int id, Type type, BasicBlock* bb,
                   Instruction* arr, Instruction* index)
         : Instruction(id, Opcode::LoadArray, type, bb) {
@@ -225,6 +440,7 @@ public:
 
 class StoreArrayInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::StoreArray; }
     StoreArrayInst(int id, Type type, BasicBlock* bb,
                    Instruction* arr, Instruction* index, Instruction* value)
         : Instruction(id, Opcode::StoreArray, type, bb) {
@@ -240,6 +456,7 @@ public:
 
 class CallInst : public Instruction {
 public:
+    static bool classof(const Instruction* inst) { return inst->GetOpcode() == Opcode::Call; }
     CallInst(int id, Type type, BasicBlock* bb, Graph* callee, const std::vector<Instruction*>& args)
         : Instruction(id, Opcode::Call, type, bb), callee_(callee) {
         for (auto* arg : args) {
@@ -258,4 +475,33 @@ public:
     }
 private:
     Graph* callee_;
-};
\ No newline at end of file
+};
+
+// Cheap replacements for dynamic_cast: every check is a compare on the
+// opcode through To::classof, so pass loops never touch RTTI.
+template <typename To>
+bool isa(const Instruction* inst) {
+    return To::classof(inst);
+}
+
+template <typename To>
+To* cast(Instruction* inst) {
+    assert(isa<To>(inst) && "cast<To>() to an incompatible instruction");
+    return static_cast<To*>(inst);
+}
+
+template <typename To>
+const To* cast(const Instruction* inst) {
+    assert(isa<To>(inst) && "cast<To>() to an incompatible instruction");
+    return static_cast<const To*>(inst);
+}
+
+template <typename To>
+To* dyn_cast(Instruction* inst) {
+    return inst && isa<To>(inst) ? static_cast<To*>(inst) : nullptr;
+}
+
+template <typename To>
+const To* dyn_cast(const Instruction* inst) {
+    return inst && isa<To>(inst) ? static_cast<const To*>(inst) : nullptr;
+}
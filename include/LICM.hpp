@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "DominatorAnalysis.hpp"
+#include "LoopAnalyzer.hpp"
+#include "PreservedAnalyses.hpp"
+
+class AnalysisManager;
+
+// Loop-invariant code motion. Every loop first gets a preheader, then
+// constants, binary operations and NullChecks whose inputs are all defined
+// outside the loop are moved into it, innermost loops first so that a
+// value can travel out of a whole nest.
+//
+// Binary operations never trap and are hoisted freely. A NullCheck is
+// moved only when it runs on every iteration (its block dominates each
+// latch and exiting block) and the loop has no stores, calls or earlier
+// checks it could be reordered with.
+class LICM {
+public:
+    LICM(Graph* graph, DominatorAnalysis* dom, LoopAnalyzer* loops)
+        : graph_(graph), dom_(dom), loops_(loops) {}
+    LICM(Graph* graph, AnalysisManager& am);
+
+    void Run();
+    size_t GetHoistedCount() const { return hoisted_count_; }
+    size_t GetPreheaderCount() const { return preheader_count_; }
+    // dominators and loops are recomputed after preheaders are inserted
+    PreservedAnalyses GetPreservedAnalyses() const {
+        if (preheader_count_) {
+            return PreservedAnalyses::None().Preserve(AnalysisKind::Dominators).Preserve(AnalysisKind::Loops);
+        }
+        return hoisted_count_ ? PreservedAnalyses::CFG() : PreservedAnalyses::All();
+    }
+
+private:
+    Graph* graph_;
+    DominatorAnalysis* dom_;
+    LoopAnalyzer* loops_;
+    size_t hoisted_count_ = 0;
+    size_t preheader_count_ = 0;
+
+    void HoistInvariants(Loop* loop, BasicBlock* preheader);
+    bool IsInvariant(const Instruction* inst, const Loop* loop) const;
+    bool RunsEveryIteration(BasicBlock* bb, const Loop* loop) const;
+};
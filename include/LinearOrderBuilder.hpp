@@ -1,9 +1,10 @@
 #pragma once
 #include "Graph.hpp"
 #include "LoopAnalyzer.hpp"
+#include "GraphMaps.hpp"
+#include "Statistics.hpp"
 #include <vector>
 #include <algorithm>
-#include <set>
 
 class LinearOrderBuilder {
 public:
@@ -11,8 +12,9 @@ public:
         : graph_(graph), loops_(loops) {}
 
     void Run() {
+        PassStatsScope stats(graph_, "LinearOrderBuilder");
         linear_blocks_.clear();
-        std::set<BasicBlock*> visited;
+        BlockMap<bool> visited(graph_, false);
         if (graph_->GetEntryBlock()) {
             ComputeOrder(graph_->GetEntryBlock(), visited);
         }
@@ -27,9 +29,9 @@ private:
     LoopAnalyzer* loops_;
     std::vector<BasicBlock*> linear_blocks_;
 
-    void ComputeOrder(BasicBlock* bb, std::set<BasicBlock*>& visited) {
-        if (visited.count(bb)) return;
-        visited.insert(bb);
+    void ComputeOrder(BasicBlock* bb, BlockMap<bool>& visited) {
+        if (visited[bb]) return;
+        visited[bb] = true;
 
         linear_blocks_.push_back(bb);
 
@@ -46,19 +48,10 @@ private:
     }
 
     int GetLoopDepth(BasicBlock* bb) {
-        if (!loops_) return 0;
-        int depth = 0;
-        for (const auto& loop : loops_->GetLoops()) {
-            if (loop->Contains(bb)) depth++;
-        }
-        return depth;
+        return loops_ ? loops_->GetLoopDepth(bb) : 0;
     }
 
     bool IsBackEdge(BasicBlock* from, BasicBlock* to) {
-        if (!loops_) return false;
-        for (const auto& loop : loops_->GetLoops()) {
-            if (loop->header == to && loop->Contains(from)) return true;
-        }
-        return false;
+        return loops_ && loops_->IsBackEdge(from, to);
     }
 };
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 #include "Graph.hpp"
+#include "GraphMaps.hpp"
 #include <vector>
-#include <map>
 #include <set>
 
 struct LiveRange {
@@ -13,7 +13,8 @@ struct LiveRange {
 };
 
 struct LiveInterval {
-    int reg_id;
+    // -1 until the value gets a live range
+    int reg_id = -1;
     std::vector<LiveRange> ranges;
     void AddRange(int from, int to) {
         if (from >= to) return;
@@ -46,15 +47,14 @@ public:
     void Run();
     const std::vector<BasicBlock*>& GetLinearOrder() const { return linear_blocks_; }
     const LiveInterval* GetInterval(int inst_id) const { 
-        auto it = intervals_.find(inst_id);
-        if (it != intervals_.end()) {
-            return &it->second;
-        }
-        return nullptr;
+        const auto& interval = intervals_.Get(inst_id);
+        return interval.reg_id >= 0 ? &interval : nullptr;
     }
     void Dump() {
         std::cout << "Liveness Intervals:\n";
-        for (auto& [id, interval] : intervals_) {
+        for (size_t id = 0; id < intervals_.size(); ++id) {
+            const auto& interval = intervals_.Get(static_cast<int>(id));
+            if (interval.reg_id < 0) continue;
             std::cout << "v" << id << ": ";
             for (auto& r : interval.ranges) {
                 std::cout << "[" << r.begin << ", " << r.end << ") ";
@@ -70,9 +70,9 @@ public:
 private:
     Graph* graph_;
     std::vector<BasicBlock*> linear_blocks_;
-    std::map<int, LiveInterval> intervals_;
-    std::map<BasicBlock*, std::set<int>> live_in_;
-    std::map<BasicBlock*, std::set<int>> live_out_;
+    InstMap<LiveInterval> intervals_;
+    BlockMap<std::set<int>> live_in_;
+    BlockMap<std::set<int>> live_out_;
     
     void NumberInstructions();
     void BuildIntervals();
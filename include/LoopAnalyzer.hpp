@@ -2,10 +2,10 @@
 
 #include "DominatorAnalysis.hpp"
 #include "Graph.hpp"
+#include "GraphMaps.hpp"
 #include <stack>
 #include <set>
 #include <vector>
-#include <unordered_map>
 #include <memory>
 #include <functional>
 
@@ -18,6 +18,8 @@ struct Loop {
     std::vector<Loop*> sub_loops;
     
     int id = 0;
+    // 1 for outermost loops, 0 for the root loop
+    int depth = 0;
     
     Loop(BasicBlock* h, int loop_id) : header(h), id(loop_id) {
         if (h) blocks.insert(h);
@@ -37,13 +39,24 @@ public:
 
     const std::vector<std::unique_ptr<Loop>>& GetLoops() const { return all_loops_; }
     Loop* GetRootLoop() const { return root_loop_.get(); }
+    // innermost loop containing bb, nullptr outside of all loops
+    Loop* GetLoopFor(const BasicBlock* bb) const { return block_loop_.Get(bb); }
+    int GetLoopDepth(const BasicBlock* bb) const {
+        Loop* loop = GetLoopFor(bb);
+        return loop ? loop->depth : 0;
+    }
+    bool IsBackEdge(BasicBlock* from, const BasicBlock* to) const {
+        Loop* loop = GetLoopFor(to);
+        return loop && loop->header == to && loop->Contains(from);
+    }
     void Dump() const;
 private:
     Graph* graph_;
     DominatorAnalysis* dom_analysis_;
     
     enum class Color { WHITE, GRAY, BLACK };
-    std::unordered_map<BasicBlock*, Color> color_;
+    BlockMap<Color> color_;
+    BlockMap<Loop*> block_loop_;
     
     std::vector<std::unique_ptr<Loop>> all_loops_;
     std::unique_ptr<Loop> root_loop_;
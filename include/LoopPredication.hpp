@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "GraphMaps.hpp"
+#include "DominatorAnalysis.hpp"
+#include "LoopAnalyzer.hpp"
+#include "PreservedAnalyses.hpp"
+#include "RangeAnalysis.hpp"
+#include <cstdint>
+#include <vector>
+
+class AnalysisManager;
+
+// Replaces the BoundsChecks of a loop on iv + c by a single test in the
+// preheader. Handled loops count a basic induction variable up from a
+// constant while iv <= bound or iv < bound, with bound and the checked
+// lengths defined outside the loop and the header as the only exit.
+//
+// The index then runs from init + c to at most bound + c (bound - 1 + c
+// for <). The first end is checked at compile time, the last one by the
+// guard, which also rejects bounds where that sum would wrap. When the
+// guard fails, control goes to an untouched copy of the loop that still
+// has its checks; the two versions meet again in the exit block.
+// Checks the range analysis already proves are left to CheckElimination.
+// Checks in the header are kept: they also run on the exiting test and
+// before a body that may never run, neither of which the guard covers.
+class LoopPredication {
+public:
+    LoopPredication(Graph* graph, DominatorAnalysis* dom, LoopAnalyzer* loops)
+        : graph_(graph), dom_(dom), loops_(loops) {}
+    LoopPredication(Graph* graph, AnalysisManager& am);
+
+    void Run();
+    size_t GetVersionedCount() const { return versioned_count_; }
+    size_t GetRemovedCount() const { return removed_count_; }
+    PreservedAnalyses GetPreservedAnalyses() const {
+        return versioned_count_ ? PreservedAnalyses::None() : PreservedAnalyses::All();
+    }
+
+private:
+    struct PredicatedCheck {
+        BoundsCheckInst* check = nullptr;
+        // the index stays below length if bound + slack does
+        int64_t slack = 0;
+    };
+
+    struct PredicatedLoop {
+        Loop* loop = nullptr;
+        BasicBlock* preheader = nullptr;
+        BasicBlock* exit = nullptr;
+        Instruction* bound = nullptr;
+        std::vector<BasicBlock*> blocks;
+        std::vector<PredicatedCheck> checks;
+    };
+
+    Graph* graph_;
+    DominatorAnalysis* dom_;
+    LoopAnalyzer* loops_;
+    size_t versioned_count_ = 0;
+    size_t removed_count_ = 0;
+
+    bool Analyze(Loop* loop, const RangeAnalysis& ranges, PredicatedLoop& info) const;
+    void Version(const PredicatedLoop& info);
+    Instruction* BuildGuard(const PredicatedLoop& info);
+};
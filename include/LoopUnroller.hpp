@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "GraphCloner.hpp"
+#include "InductionVariables.hpp"
+#include "LoopAnalyzer.hpp"
+#include "PreservedAnalyses.hpp"
+#include <cstdint>
+#include <vector>
+
+class AnalysisManager;
+
+// Unrolls innermost counted loops: a single latch ending in a jump, a
+// preheader, and a header that is the only exit, branching on a Cmp of a
+// basic induction variable with constant init against a constant.
+//
+// Loops running at most max_full_trip_count iterations are replaced by
+// straight-line copies of their body. Longer ones get an unrolled loop in
+// front whose header checks that factor more iterations remain; the
+// original loop then runs the remaining iterations and keeps producing
+// the exit values.
+class LoopUnroller {
+public:
+    static constexpr size_t kDefaultFactor = 4;
+    static constexpr int64_t kDefaultMaxFullTripCount = 8;
+    static constexpr size_t kDefaultMaxUnrolledSize = 256;
+    // trip counts are found by stepping the induction variable this far
+    static constexpr int64_t kMaxTripCount = 1 << 16;
+
+    LoopUnroller(Graph* graph, LoopAnalyzer* loops) : graph_(graph), loops_(loops), cloner_(graph, graph) {}
+    LoopUnroller(Graph* graph, AnalysisManager& am);
+
+    // 1 turns partial unrolling off
+    void SetFactor(size_t factor) { factor_ = factor; }
+    void SetMaxFullTripCount(int64_t count) { max_full_trip_count_ = count; }
+    // limit on the instructions of all copies of one loop
+    void SetMaxUnrolledSize(size_t size) { max_unrolled_size_ = size; }
+
+    void Run();
+    size_t GetFullyUnrolledCount() const { return fully_unrolled_; }
+    size_t GetPartiallyUnrolledCount() const { return partially_unrolled_; }
+    PreservedAnalyses GetPreservedAnalyses() const {
+        return fully_unrolled_ || partially_unrolled_ ? PreservedAnalyses::None() : PreservedAnalyses::All();
+    }
+
+private:
+    struct CountedLoop {
+        Loop* loop = nullptr;
+        BasicBlock* preheader = nullptr;
+        BasicBlock* latch = nullptr;
+        BasicBlock* body_entry = nullptr;
+        BasicBlock* exit = nullptr;
+        IfInst* branch = nullptr;
+        BinaryInst* cond = nullptr;
+        const BasicInductionVariable* iv = nullptr;
+        Instruction* limit = nullptr;
+        bool iv_on_left = true;
+        bool continue_on_true = true;
+        // the condition only feeds the branch and is not copied
+        bool skip_cond = false;
+        int64_t trip_count = 0;
+        size_t size = 0;
+        // loop blocks other than the header, in RPO
+        std::vector<BasicBlock*> body;
+    };
+
+    Graph* graph_;
+    LoopAnalyzer* loops_;
+    size_t factor_ = kDefaultFactor;
+    int64_t max_full_trip_count_ = kDefaultMaxFullTripCount;
+    size_t max_unrolled_size_ = kDefaultMaxUnrolledSize;
+    size_t fully_unrolled_ = 0;
+    size_t partially_unrolled_ = 0;
+
+    // value of every loop instruction in the iteration being emitted
+    GraphCloner cloner_;
+
+    bool Analyze(Loop* loop, const InductionVariableAnalysis& ivs, CountedLoop& info) const;
+    bool IsTaken(const CountedLoop& info, int64_t iv_value) const;
+    int64_t ComputeTripCount(const CountedLoop& info) const;
+    bool StaysInRange(const CountedLoop& info, int64_t iterations) const;
+
+    void FullyUnroll(const CountedLoop& info);
+    void PartiallyUnroll(const CountedLoop& info);
+    void StartIterations(const CountedLoop& info);
+    void CopyHeader(const CountedLoop& info, BasicBlock* into);
+    BasicBlock* CopyBody(const CountedLoop& info, BasicBlock* tail);
+    void AdvancePhis(const CountedLoop& info);
+    void Retarget(const CountedLoop& info, BasicBlock* from, BasicBlock* to);
+    Instruction* Lookup(Instruction* inst) const;
+};
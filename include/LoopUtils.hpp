@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "GraphMaps.hpp"
+#include "LoopAnalyzer.hpp"
+#include <vector>
+
+// CFG helpers shared by the loop transforms. They edit the graph only;
+// dominators and loops have to be recomputed by the caller afterwards.
+class LoopUtils {
+public:
+    // The single block outside the loop that enters it and jumps nowhere
+    // but the header, or nullptr.
+    static BasicBlock* GetPreheader(const Loop* loop);
+    // Returns the preheader, first routing every entering edge through a
+    // new block when the loop has none. Header phis get a single input
+    // from that block, merged there by a new phi when the entering
+    // values differ.
+    static BasicBlock* EnsurePreheader(Graph* graph, Loop* loop);
+    // Loops of the tree below root, innermost first.
+    static std::vector<Loop*> GetLoopsInnermostFirst(Loop* root);
+};
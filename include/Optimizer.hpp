@@ -2,15 +2,41 @@
 
 #include "Graph.hpp"
 #include "IRBuilder.hpp"
+#include "InstVisitor.hpp"
+#include "PreservedAnalyses.hpp"
+#include "GraphMaps.hpp"
+#include <deque>
 
-class Optimizer {
+// Worklist driven: every instruction is visited once, and only the users
+// of a simplified instruction (plus any constant it produced) are queued
+// again.
+class Optimizer : public InstVisitor<Optimizer, bool> {
 public:
     explicit Optimizer(Graph* graph) : graph_(graph) {}
     void Run();
+    PreservedAnalyses GetPreservedAnalyses() const {
+        if (cfg_changed_) return PreservedAnalyses::None();
+        return changed_ ? PreservedAnalyses::CFG() : PreservedAnalyses::All();
+    }
 private:
+    friend class InstVisitor<Optimizer, bool>;
+
     Graph* graph_;
-    bool TryConstantFolding(Instruction* inst);
-    bool TryPeephole(Instruction* inst);
-    void ReplaceAllUses(Instruction* oldInst, Instruction* newInst);
+    bool changed_ = false;
+    bool cfg_changed_ = false;
+    bool pending_unreachable_ = false;
+    std::deque<Instruction*> worklist_;
+    InstMap<bool> queued_;
+
+    void Enqueue(Instruction* inst);
+    void EnqueuePhis(BasicBlock* bb);
+    void ReplaceWith(Instruction* inst, Instruction* value);
+    ConstantInst* NewConstant(Instruction* before, Type type, int64_t value);
+    bool RemoveUnreachableBlocks();
+    bool VisitBinary(BinaryInst* bin);
+    bool VisitPhi(PhiInst* phi);
+    bool VisitIf(IfInst* branch);
+    bool TryConstantFolding(BinaryInst* bin);
+    bool TryPeephole(BinaryInst* bin);
 };
 
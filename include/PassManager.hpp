@@ -0,0 +1,50 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "AnalysisManager.hpp"
+
+// Runs transforms over one graph in order. A pass is any class with Run()
+// and GetPreservedAnalyses(); it is built from (Graph*, AnalysisManager&)
+// when it has such a constructor and from (Graph*) otherwise, right before
+// it runs, so it sees the analyses left valid by the passes before it.
+class PassManager {
+public:
+    explicit PassManager(Graph* graph) : graph_(graph), analyses_(graph) {}
+
+    template <typename T>
+    void AddPass() {
+        passes_.push_back([](Graph* graph, AnalysisManager& am) {
+            auto pass = Create<T>(graph, am);
+            pass->Run();
+            return pass->GetPreservedAnalyses();
+        });
+    }
+
+    void Run() {
+        for (auto& pass : passes_) {
+            analyses_.Invalidate(pass(graph_, analyses_));
+        }
+    }
+
+    AnalysisManager& GetAnalysisManager() { return analyses_; }
+    size_t GetPassCount() const { return passes_.size(); }
+
+private:
+    using PassFunc = std::function<PreservedAnalyses(Graph*, AnalysisManager&)>;
+
+    Graph* graph_;
+    AnalysisManager analyses_;
+    std::vector<PassFunc> passes_;
+
+    template <typename T>
+    static std::unique_ptr<T> Create(Graph* graph, AnalysisManager& am) {
+        if constexpr (std::is_constructible_v<T, Graph*, AnalysisManager&>) {
+            return std::make_unique<T>(graph, am);
+        } else {
+            return std::make_unique<T>(graph);
+        }
+    }
+};
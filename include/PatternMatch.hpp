@@ -0,0 +1,126 @@
+#pragma once
+
+#include "ConstantFolding.hpp"
+#include "Instruction.hpp"
+
+// Declarative matchers for instruction trees, e.g.
+//
+//     Instruction* x = nullptr;
+//     if (Match(inst, m_Mul(m_Value(x), m_ConstInt(1)))) ...
+//
+// Every matcher is a small value type with a Match(Instruction*) member,
+// so a pattern is a nested template that inlines down to the opcode and
+// operand tests it spells out. Binding matchers write their result even
+// when an enclosing pattern fails later, so bound values are only
+// meaningful after Match returned true.
+namespace PatternMatch {
+
+template <typename Pattern>
+bool Match(Instruction* inst, Pattern pattern) {
+    return pattern.Match(inst);
+}
+
+struct AnyValue {
+    bool Match(Instruction* inst) const { return inst != nullptr; }
+};
+
+struct BindValue {
+    Instruction*& bound;
+    bool Match(Instruction* inst) const {
+        bound = inst;
+        return inst != nullptr;
+    }
+};
+
+struct SpecificValue {
+    const Instruction* value;
+    bool Match(Instruction* inst) const { return inst == value; }
+};
+
+// Compares against a value bound earlier in the same pattern; operands
+// are matched left to right.
+struct DeferredValue {
+    Instruction* const& value;
+    bool Match(Instruction* inst) const { return inst == value; }
+};
+
+struct SpecificConstInt {
+    int64_t value;
+    bool Match(Instruction* inst) const {
+        auto* constant = dyn_cast<ConstantInst>(inst);
+        return constant && GetConstantValue(constant) == value;
+    }
+};
+
+struct BindConstInt {
+    int64_t& bound;
+    bool Match(Instruction* inst) const {
+        auto* constant = dyn_cast<ConstantInst>(inst);
+        if (!constant) return false;
+        bound = GetConstantValue(constant);
+        return true;
+    }
+};
+
+// A positive power of two, binding its base-2 logarithm.
+struct BindPowerOfTwo {
+    int64_t& log2;
+    bool Match(Instruction* inst) const {
+        auto* constant = dyn_cast<ConstantInst>(inst);
+        if (!constant) return false;
+        int64_t value = GetConstantValue(constant);
+        if (value <= 0 || (value & (value - 1)) != 0) return false;
+        log2 = __builtin_ctzll(static_cast<unsigned long long>(value));
+        return true;
+    }
+};
+
+template <Opcode Op, bool Commutable, typename LHS, typename RHS>
+struct BinaryMatch {
+    LHS lhs;
+    RHS rhs;
+    bool Match(Instruction* inst) const {
+        if (!inst || inst->GetOpcode() != Op) return false;
+        Instruction* first = inst->GetInput(0);
+        Instruction* second = inst->GetInput(1);
+        if (lhs.Match(first) && rhs.Match(second)) return true;
+        return Commutable && lhs.Match(second) && rhs.Match(first);
+    }
+};
+
+inline AnyValue m_Value() { return {}; }
+inline BindValue m_Value(Instruction*& bound) { return {bound}; }
+inline SpecificValue m_Specific(const Instruction* value) { return {value}; }
+inline DeferredValue m_Deferred(Instruction* const& value) { return {value}; }
+inline SpecificConstInt m_ConstInt(int64_t value) { return {value}; }
+inline BindConstInt m_AnyConstInt(int64_t& bound) { return {bound}; }
+inline BindPowerOfTwo m_PowerOfTwo(int64_t& log2) { return {log2}; }
+inline SpecificConstInt m_Zero() { return {0}; }
+inline SpecificConstInt m_One() { return {1}; }
+inline SpecificConstInt m_AllOnes() { return {-1}; }
+
+#define PATTERN_MATCH_BINARY(Name, Op, Commutable)                                  \
+    template <typename LHS, typename RHS>                                           \
+    BinaryMatch<Op, Commutable, LHS, RHS> Name(LHS lhs, RHS rhs) { return {lhs, rhs}; }
+
+PATTERN_MATCH_BINARY(m_Add, Opcode::Add, false)
+PATTERN_MATCH_BINARY(m_Sub, Opcode::Sub, false)
+PATTERN_MATCH_BINARY(m_Mul, Opcode::Mul, false)
+PATTERN_MATCH_BINARY(m_Or, Opcode::Or, false)
+PATTERN_MATCH_BINARY(m_AShr, Opcode::AShr, false)
+PATTERN_MATCH_BINARY(m_Shl, Opcode::Shl, false)
+PATTERN_MATCH_BINARY(m_Cmp, Opcode::Cmp, false)
+// either operand order
+PATTERN_MATCH_BINARY(m_c_Add, Opcode::Add, true)
+PATTERN_MATCH_BINARY(m_c_Mul, Opcode::Mul, true)
+PATTERN_MATCH_BINARY(m_c_Or, Opcode::Or, true)
+
+#undef PATTERN_MATCH_BINARY
+
+// 0 - x
+template <typename Operand>
+BinaryMatch<Opcode::Sub, false, SpecificConstInt, Operand> m_Neg(Operand operand) {
+    return {m_Zero(), operand};
+}
+
+} // namespace PatternMatch
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Graph.hpp"
+#include <vector>
+
+// Creates the instructions of a rewrite right before the instruction
+// being replaced, in its type.
+class PeepholeBuilder {
+public:
+    PeepholeBuilder(Graph* graph, BinaryInst* root) : graph_(graph), root_(root) {}
+
+    Instruction* Constant(int64_t value);
+    Instruction* Binary(Opcode opcode, Instruction* lhs, Instruction* rhs);
+    const std::vector<Instruction*>& GetCreated() const { return created_; }
+
+private:
+    Graph* graph_;
+    BinaryInst* root_;
+    std::vector<Instruction*> created_;
+};
+
+// A rule returns the value that replaces inst, or nullptr without having
+// created anything when it does not apply.
+using PeepholeRule = Instruction* (*)(BinaryInst* inst, PeepholeBuilder& builder);
+
+// Algebraic identities for the Optimizer, bucketed by the opcode of the
+// instruction they rewrite. Rules for one opcode are tried in order, so
+// special cases come before the general ones.
+class PeepholeRules {
+public:
+    static const std::vector<PeepholeRule>& For(Opcode opcode);
+};
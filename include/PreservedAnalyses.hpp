@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+// Listed so that every analysis comes after the ones it is built from.
+enum class AnalysisKind : uint32_t { Dominators, Loops, LinearOrder, Liveness, Count };
+
+// Set of analyses a transform left valid. Transforms that only rewrite
+// instructions keep the CFG analyses; everything else has to be recomputed.
+class PreservedAnalyses {
+public:
+    static PreservedAnalyses None() { return PreservedAnalyses(0); }
+    static PreservedAnalyses All() { return PreservedAnalyses(Bit(AnalysisKind::Count) - 1); }
+    static PreservedAnalyses CFG() {
+        return None().Preserve(AnalysisKind::Dominators)
+                     .Preserve(AnalysisKind::Loops)
+                     .Preserve(AnalysisKind::LinearOrder);
+    }
+
+    PreservedAnalyses& Preserve(AnalysisKind kind) { mask_ |= Bit(kind); return *this; }
+    PreservedAnalyses& Abandon(AnalysisKind kind) { mask_ &= ~Bit(kind); return *this; }
+    bool IsPreserved(AnalysisKind kind) const { return (mask_ & Bit(kind)) != 0; }
+    PreservedAnalyses& Intersect(const PreservedAnalyses& other) { mask_ &= other.mask_; return *this; }
+
+    static constexpr uint32_t Bit(AnalysisKind kind) { return 1u << static_cast<uint32_t>(kind); }
+private:
+    explicit PreservedAnalyses(uint32_t mask) : mask_(mask) {}
+    uint32_t mask_;
+};
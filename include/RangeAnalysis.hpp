@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "GraphMaps.hpp"
+#include "DominatorAnalysis.hpp"
+#include "InductionVariables.hpp"
+#include "LoopAnalyzer.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+// Closed interval of the signed values an instruction can take.
+struct ValueRange {
+    int64_t min = std::numeric_limits<int64_t>::min();
+    int64_t max = std::numeric_limits<int64_t>::max();
+
+    static ValueRange Full(Type type) {
+        if (type == Type::int32) return {std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()};
+        return {};
+    }
+    static ValueRange Constant(int64_t value) { return {value, value}; }
+
+    bool IsConstant() const { return min == max; }
+    ValueRange Union(const ValueRange& other) const { return {std::min(min, other.min), std::max(max, other.max)}; }
+    bool operator==(const ValueRange& other) const { return min == other.min && max == other.max; }
+};
+
+// Flow-insensitive ranges for every instruction, computed once in RPO,
+// plus queries that narrow them at a block by the Cmp + If edges that
+// must have been taken to reach it.
+//
+// Basic induction variables with constant init are bounded by init on
+// one side, as long as the branches guarding their update show that the
+// step cannot wrap. Other phis are the union of their inputs, which is
+// the full range as soon as one input comes around a back edge.
+class RangeAnalysis {
+public:
+    RangeAnalysis(Graph* graph, DominatorAnalysis* dom, LoopAnalyzer* loops)
+        : graph_(graph), dom_(dom), ivs_(graph, loops) {}
+
+    void Run();
+    ValueRange GetRange(const Instruction* inst) const;
+    ValueRange GetRangeAt(Instruction* value, BasicBlock* bb) const { return RangeAt(value, bb, 0); }
+    // lhs < rhs wherever bb runs
+    bool ProvesLess(Instruction* lhs, Instruction* rhs, BasicBlock* bb) const;
+    const InductionVariableAnalysis& GetInductionVariables() const { return ivs_; }
+
+private:
+    // comparisons of the other operand are followed this deep
+    static constexpr int kMaxDepth = 2;
+
+    Graph* graph_;
+    DominatorAnalysis* dom_;
+    InductionVariableAnalysis ivs_;
+    InstMap<ValueRange> ranges_;
+    InstMap<bool> computed_;
+
+    ValueRange RangeAt(Instruction* value, BasicBlock* bb, int depth) const;
+    ValueRange Compute(Instruction* inst) const;
+    ValueRange ComputeInductionVariable(const BasicInductionVariable* iv);
+
+    // Calls fn(cmp, holds) for every Cmp known to be holds at bb: the If
+    // ending the only predecessor of each block on bb's dominator chain.
+    template <typename Fn>
+    void ForEachFact(BasicBlock* bb, Fn fn) const {
+        for (BasicBlock* block = bb; block; block = dom_->GetIdom(block)) {
+            if (block->GetPreds().size() != 1) continue;
+            auto* branch = dyn_cast<IfInst>(block->GetPreds()[0]->GetLastInst());
+            if (!branch || branch->GetTrueTarget() == branch->GetFalseTarget()) continue;
+            auto* cmp = dyn_cast<BinaryInst>(branch->GetInput(0));
+            if (cmp && cmp->GetOpcode() == Opcode::Cmp) fn(cmp, branch->GetTrueTarget() == block);
+        }
+    }
+};
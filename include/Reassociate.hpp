@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "GraphMaps.hpp"
+#include "PreservedAnalyses.hpp"
+#include <cstdint>
+#include <vector>
+
+// Rewrites trees of one associative and commutative opcode (Add, Mul,
+// Or) into a canonical left-leaning chain. A tree is grown through
+// operands of the same opcode and type that have no other use and live
+// in the same block. Its leaves are ordered by rank - the RPO position
+// of the block a value comes from - so operands defined outside a loop
+// are combined before the loop-variant ones and LICM can hoist the
+// partial result. All constants are folded into one that ends the chain,
+// and trees with the same leaves get the same shape for GVN.
+class Reassociate {
+public:
+    explicit Reassociate(Graph* graph) : graph_(graph) {}
+
+    void Run();
+    size_t GetRewrittenCount() const { return rewritten_count_; }
+    // arithmetic instructions saved by combining constants
+    size_t GetRemovedCount() const { return removed_count_; }
+    PreservedAnalyses GetPreservedAnalyses() const {
+        return rewritten_count_ ? PreservedAnalyses::CFG() : PreservedAnalyses::All();
+    }
+
+private:
+    struct Tree {
+        BinaryInst* root = nullptr;
+        std::vector<Instruction*> leaves;
+        std::vector<Instruction*> nodes;
+    };
+
+    Graph* graph_;
+    InstMap<int64_t> ranks_;
+    size_t rewritten_count_ = 0;
+    size_t removed_count_ = 0;
+
+    void ComputeRanks();
+    bool IsInnerNode(Instruction* inst, const BinaryInst* root) const;
+    bool IsTreeRoot(BinaryInst* inst) const;
+    void Collect(Instruction* inst, Tree& tree) const;
+    bool Rewrite(Tree& tree);
+};
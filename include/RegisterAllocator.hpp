@@ -1,8 +1,8 @@
 #pragma once
 #include "LivenessAnalysis.hpp"
+#include "Statistics.hpp"
 #include <vector>
 #include <list>
-#include <map>
 #include <iostream>
 #include <algorithm>
 
@@ -23,6 +23,8 @@ public:
         : graph_(graph), liveness_(liveness), R_int(num_int_regs), R_float(num_float_regs) {}
 
     void Run() {
+        PassStatsScope stats(graph_, "LinearScanAllocator");
+        allocations_.Reset(graph_);
         InitializeFreeRegisters();
         
         std::vector<const LiveInterval*> sorted_intervals;
@@ -57,7 +59,7 @@ public:
         DumpAllocations();
     }
 
-    Location GetLocation(int reg_id) { return allocations_[reg_id]; }
+    Location GetLocation(int reg_id) const { return allocations_.Get(reg_id); }
 
 private:
     Graph* graph_;
@@ -67,7 +69,7 @@ private:
     
     std::vector<int> free_registers_;
     std::vector<const LiveInterval*> active_;
-    std::map<int, Location> allocations_;
+    InstMap<Location> allocations_;
     int next_stack_slot_ = 0;
 
     static int GetStart(const LiveInterval* iv) { return iv->ranges.empty() ? 0 : iv->ranges.front().begin; }
@@ -101,10 +103,12 @@ private:
     }
 
     void SpillAtInterval(const LiveInterval* i) {
+        Statistics::Count(graph_, "LinearScanAllocator", "spills");
         const LiveInterval* spill = active_.back();
         
         if (GetEnd(spill) > GetEnd(i)) {
-            allocations_[i->reg_id] = allocations_[spill->reg_id];
+            Location spill_loc = allocations_[spill->reg_id];
+            allocations_[i->reg_id] = spill_loc;
             allocations_[spill->reg_id] = {Location::Kind::Stack, next_stack_slot_++};
             
             active_.pop_back();
@@ -116,7 +120,9 @@ private:
 
     void DumpAllocations() const {
         std::cout << "\n=== Register Allocation ===\n";
-        for (const auto& [id, loc] : allocations_) {
+        for (size_t id = 0; id < allocations_.size(); ++id) {
+            const auto& loc = allocations_.Get(static_cast<int>(id));
+            if (loc.kind == Location::Kind::Unassigned) continue;
             std::cout << "v" << id << " -> " << loc.ToString() << "\n";
         }
         std::cout << "===========================\n";
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "GraphMaps.hpp"
+#include "PreservedAnalyses.hpp"
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+// Sparse conditional constant propagation (Wegman-Zadeck). Values start
+// unknown and only move down the lattice unknown -> constant ->
+// overdefined; blocks are considered only once an executable edge
+// reaches them. Afterwards constant values are materialized, branches
+// with a known outcome become jumps and blocks that never executed are
+// removed.
+class SCCP {
+public:
+    explicit SCCP(Graph* graph) : graph_(graph) {}
+
+    void Run();
+    size_t GetConstantCount() const { return constants_; }
+    size_t GetFoldedBranchCount() const { return folded_branches_; }
+    PreservedAnalyses GetPreservedAnalyses() const {
+        if (folded_branches_) return PreservedAnalyses::None();
+        return constants_ ? PreservedAnalyses::CFG() : PreservedAnalyses::All();
+    }
+
+    struct LatticeValue {
+        enum class Kind { Unknown, Constant, Overdefined } kind = Kind::Unknown;
+        int64_t value = 0;
+
+        bool IsConstant() const { return kind == Kind::Constant; }
+        bool operator==(const LatticeValue& other) const {
+            return kind == other.kind && (kind != Kind::Constant || value == other.value);
+        }
+        bool operator!=(const LatticeValue& other) const { return !(*this == other); }
+    };
+
+    // lattice value computed by the last Run, for inspection
+    LatticeValue GetValue(const Instruction* inst) const { return values_.Get(inst); }
+    bool IsExecutable(const BasicBlock* bb) const { return executable_.Get(bb); }
+
+private:
+    Graph* graph_;
+    InstMap<LatticeValue> values_;
+    BlockMap<bool> executable_;
+    std::set<std::pair<int, int>> executable_edges_;
+    // blocks reached by a newly executable edge
+    std::vector<BasicBlock*> cfg_worklist_;
+    std::vector<Instruction*> ssa_worklist_;
+    size_t constants_ = 0;
+    size_t folded_branches_ = 0;
+
+    void Solve();
+    void MarkEdge(BasicBlock* from, BasicBlock* to);
+    void VisitInst(Instruction* inst);
+    LatticeValue Evaluate(Instruction* inst) const;
+    LatticeValue EvaluatePhi(PhiInst* phi) const;
+    bool IsEdgeExecutable(const BasicBlock* from, const BasicBlock* to) const {
+        return executable_edges_.count({from->GetId(), to->GetId()}) != 0;
+    }
+
+    void Rewrite();
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "GraphMaps.hpp"
+#include "PreservedAnalyses.hpp"
+#include <vector>
+
+// Cleans up the block structure left behind by inlining, unrolling and
+// branch folding, repeating until nothing changes:
+//  - a block is merged into its predecessor when it is that block's only
+//    successor and has no other predecessor;
+//  - a block holding nothing but a Jump is bypassed, its predecessors
+//    branch to the target directly and the target's phis get one input
+//    per predecessor;
+//  - an If on a phi of its block is threaded: a predecessor whose
+//    incoming value is a constant branches straight to the known target,
+//    provided the block holds nothing else and is not a loop header,
+//    which would leave the loop with a second entry.
+// Blocks the entry cannot reach are dropped first.
+class SimplifyCFG {
+public:
+    explicit SimplifyCFG(Graph* graph) : graph_(graph) {}
+
+    void Run();
+    size_t GetMergedCount() const { return merged_count_; }
+    size_t GetRemovedCount() const { return removed_count_; }
+    size_t GetThreadedCount() const { return threaded_count_; }
+    PreservedAnalyses GetPreservedAnalyses() const {
+        return changed_ ? PreservedAnalyses::None() : PreservedAnalyses::All();
+    }
+
+private:
+    Graph* graph_;
+    bool changed_ = false;
+    size_t merged_count_ = 0;
+    size_t removed_count_ = 0;
+    size_t threaded_count_ = 0;
+    // blocks cut off during the current sweep; they stay listed in its RPO
+    // snapshot and are freed together once it ends
+    std::vector<BasicBlock*> removed_;
+    BlockMap<bool> is_removed_;
+    // position in that snapshot, to tell retreating edges apart
+    BlockMap<size_t> rpo_index_;
+
+    bool MergeIntoPredecessor(BasicBlock* bb);
+    bool RemoveEmptyBlock(BasicBlock* bb);
+    bool ThreadJumps(BasicBlock* bb);
+    void Remove(BasicBlock* bb);
+};
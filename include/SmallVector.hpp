@@ -0,0 +1,163 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Vector with room for N elements inside the object itself. Only when it
+// grows past N does it move its elements to the heap, so the common small
+// operand, phi and edge lists of the IR never allocate.
+template <typename T, size_t N>
+class SmallVector {
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+
+    SmallVector() = default;
+
+    SmallVector(std::initializer_list<T> init) {
+        reserve(init.size());
+        for (const auto& value : init) push_back(value);
+    }
+
+    SmallVector(const SmallVector& other) {
+        reserve(other.size());
+        std::uninitialized_copy(other.begin(), other.end(), begin_);
+        size_ = other.size_;
+    }
+
+    SmallVector(SmallVector&& other) noexcept {
+        MoveFrom(std::move(other));
+    }
+
+    ~SmallVector() {
+        std::destroy(begin(), end());
+        if (!IsInline()) ::operator delete(begin_);
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this == &other) return *this;
+        clear();
+        reserve(other.size());
+        std::uninitialized_copy(other.begin(), other.end(), begin_);
+        size_ = other.size_;
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this == &other) return *this;
+        clear();
+        if (!IsInline()) {
+            ::operator delete(begin_);
+            begin_ = InlineData();
+            capacity_ = N;
+        }
+        MoveFrom(std::move(other));
+        return *this;
+    }
+
+    iterator begin() { return begin_; }
+    iterator end() { return begin_ + size_; }
+    const_iterator begin() const { return begin_; }
+    const_iterator end() const { return begin_ + size_; }
+
+    T* data() { return begin_; }
+    const T* data() const { return begin_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    T& operator[](size_t i) { assert(i < size_); return begin_[i]; }
+    const T& operator[](size_t i) const { assert(i < size_); return begin_[i]; }
+    T& front() { return begin_[0]; }
+    const T& front() const { return begin_[0]; }
+    T& back() { return begin_[size_ - 1]; }
+    const T& back() const { return begin_[size_ - 1]; }
+
+    void push_back(const T& value) {
+        if (size_ == capacity_) {
+            T copy(value);
+            Grow(capacity_ * 2);
+            new (begin_ + size_) T(std::move(copy));
+        } else {
+            new (begin_ + size_) T(value);
+        }
+        size_++;
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) Grow(capacity_ * 2);
+        new (begin_ + size_) T(std::forward<Args>(args)...);
+        return begin_[size_++];
+    }
+
+    void pop_back() {
+        assert(size_ > 0);
+        begin_[--size_].~T();
+    }
+
+    iterator erase(const_iterator pos) {
+        auto* it = const_cast<T*>(pos);
+        std::move(it + 1, end(), it);
+        pop_back();
+        return it;
+    }
+
+    void clear() {
+        std::destroy(begin(), end());
+        size_ = 0;
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity > capacity_) Grow(capacity);
+    }
+
+    void resize(size_t size) {
+        reserve(size);
+        while (size_ < size) emplace_back();
+        while (size_ > size) pop_back();
+    }
+
+private:
+    T* begin_ = InlineData();
+    uint32_t size_ = 0;
+    uint32_t capacity_ = N;
+    alignas(T) std::byte inline_[N * sizeof(T)];
+
+    T* InlineData() { return std::launder(reinterpret_cast<T*>(inline_)); }
+    bool IsInline() const { return begin_ == reinterpret_cast<const T*>(inline_); }
+
+    void Grow(size_t capacity) {
+        if (capacity < 2) capacity = 2;
+        assert(capacity <= UINT32_MAX);
+        auto* data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+        std::uninitialized_move(begin(), end(), data);
+        std::destroy(begin(), end());
+        if (!IsInline()) ::operator delete(begin_);
+        begin_ = data;
+        capacity_ = static_cast<uint32_t>(capacity);
+    }
+
+    void MoveFrom(SmallVector&& other) {
+        if (other.IsInline()) {
+            std::uninitialized_move(other.begin(), other.end(), begin_);
+            size_ = other.size_;
+            other.clear();
+        } else {
+            begin_ = other.begin_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.begin_ = other.InlineData();
+            other.size_ = 0;
+            other.capacity_ = N;
+        }
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Graph;
+
+// Process-wide registry of per-graph, per-pass compile statistics. It is
+// off by default; while disabled every hook returns after reading one
+// flag, so instrumented passes pay nothing measurable.
+class Statistics {
+public:
+    struct PassRecord {
+        size_t runs = 0;
+        double time_ms = 0.0;
+        // summed over runs, e.g. insts_before or spills
+        std::map<std::string, int64_t, std::less<>> counters;
+    };
+
+    static Statistics& Get();
+    static bool IsEnabled() { return enabled_; }
+    static void SetEnabled(bool enabled) { enabled_ = enabled; }
+
+    static void Count(const Graph* graph, std::string_view pass, std::string_view counter, int64_t delta = 1) {
+        if (!enabled_) return;
+        Get().AddCounter(graph, pass, counter, delta);
+    }
+
+    // graphs without a name are reported as graph<N> in first-seen order
+    void SetGraphName(const Graph* graph, std::string name);
+    PassRecord& Record(const Graph* graph, std::string_view pass);
+    const PassRecord* Find(const Graph* graph, std::string_view pass) const;
+    void AddCounter(const Graph* graph, std::string_view pass, std::string_view counter, int64_t delta);
+
+    std::string ToJson(const Graph* graph) const;
+    // every graph plus the per-pass totals over all of them
+    std::string ToJson() const;
+    void Reset() {
+        graphs_.clear();
+        graph_index_.clear();
+    }
+
+private:
+    struct GraphRecord {
+        std::string name;
+        std::map<std::string, PassRecord, std::less<>> passes;
+    };
+
+    // first-seen order for the report; looked up by Graph::GetUid, since a
+    // new graph may be allocated where a finished one used to be
+    std::vector<GraphRecord> graphs_;
+    std::unordered_map<uint64_t, size_t> graph_index_;
+    inline static bool enabled_ = false;
+
+    GraphRecord& FindOrAdd(const Graph* graph);
+    const GraphRecord* FindGraph(const Graph* graph) const;
+};
+
+// Times one pass or analysis run and records the instruction and block
+// counts of the graph before and after it.
+class PassStatsScope {
+public:
+    PassStatsScope(const Graph* graph, std::string_view pass);
+    ~PassStatsScope();
+    PassStatsScope(const PassStatsScope&) = delete;
+    PassStatsScope& operator=(const PassStatsScope&) = delete;
+
+private:
+    const Graph* graph_ = nullptr;
+    std::string_view pass_;
+    std::chrono::steady_clock::time_point start_;
+    int64_t insts_before_ = 0;
+    int64_t blocks_before_ = 0;
+};
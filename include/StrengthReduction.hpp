@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Graph.hpp"
+#include "InductionVariables.hpp"
+#include "LoopAnalyzer.hpp"
+#include "PreservedAnalyses.hpp"
+#include <map>
+#include <tuple>
+
+class AnalysisManager;
+
+// Replaces every Mul or Shl that is an induction variable, scale * iv + offset,
+// by a new phi that starts at its value for the initial iv and is advanced
+// by scale * step in the latch. Afterwards equal basic variables of a
+// loop are merged and variables only feeding their own update are
+// removed. Loops without a preheader are skipped.
+class StrengthReduction {
+public:
+    StrengthReduction(Graph* graph, LoopAnalyzer* loops) : graph_(graph), loops_(loops) {}
+    StrengthReduction(Graph* graph, AnalysisManager& am);
+
+    void Run();
+    size_t GetReducedCount() const { return reduced_count_; }
+    size_t GetRemovedIVCount() const { return removed_iv_count_; }
+    PreservedAnalyses GetPreservedAnalyses() const {
+        return reduced_count_ || removed_iv_count_ ? PreservedAnalyses::CFG() : PreservedAnalyses::All();
+    }
+
+private:
+    using IVKey = std::tuple<const BasicInductionVariable*, int64_t, int64_t>;
+
+    Graph* graph_;
+    LoopAnalyzer* loops_;
+    std::map<IVKey, PhiInst*> reduced_;
+    size_t reduced_count_ = 0;
+    size_t removed_iv_count_ = 0;
+
+    PhiInst* GetReducedVariable(const InductionVariable& iv, Type type);
+    void RemoveRedundantVariables();
+    void Erase(Instruction* inst);
+};
@@ -1,8 +1,21 @@
 #include "CheckElimination.hpp"
+#include "AnalysisManager.hpp"
+#include "RangeAnalysis.hpp"
+#include "Statistics.hpp"
 #include <map>
+#include <memory>
+
+CheckElimination::CheckElimination(Graph* graph, AnalysisManager& am)
+    : CheckElimination(graph, &am.Get<DominatorAnalysis>(), &am.Get<LoopAnalyzer>()) {}
 
 void CheckElimination::Run() {
+    PassStatsScope stats(graph_, "CheckElimination");
+    int removed_before = removed_count_;
+    int proven_before = proven_count_;
     RemoveDominatedChecks();
+    RemoveProvenChecks();
+    Statistics::Count(graph_, "CheckElimination", "removed", removed_count_ - removed_before);
+    Statistics::Count(graph_, "CheckElimination", "proven", proven_count_ - proven_before);
 }
 
 static bool IsBefore(Instruction* first, Instruction* second) {
@@ -13,15 +26,8 @@ static bool IsBefore(Instruction* first, Instruction* second) {
     return false;
 }
 
-void CheckElimination::ReplaceAllUses(Instruction* oldInst, Instruction* newInst) {
-    auto users = oldInst->GetUsers();
-    for (auto* user : users) {
-        user->ReplaceInput(oldInst, newInst);
-    }
-}
-
 void CheckElimination::RemoveDominatedChecks() {
-    auto rpo = graph_->GetRPO();
+    const auto& rpo = graph_->GetRPO();
 
     for (auto* bb : rpo) {
         Instruction* inst = bb->GetFirstInst();
@@ -59,15 +65,45 @@ void CheckElimination::RemoveDominatedChecks() {
             }
 
             if (dominating) {
-                ReplaceAllUses(inst, dominating);
+                inst->ReplaceAllUsesWith(dominating);
                 bb->RemoveInst(inst);
-                for (auto* input : inst->GetInputs()) {
-                    if (input) input->RemoveUser(inst);
-                }
-                delete inst;
+                inst->DropInputs();
+                graph_->FreeInstruction(inst);
                 removed_count_++;
             }
             inst = next;
         }
     }
 }
+
+void CheckElimination::RemoveProvenChecks() {
+    std::unique_ptr<LoopAnalyzer> own_loops;
+    LoopAnalyzer* loops = loops_;
+    if (!loops) {
+        own_loops = std::make_unique<LoopAnalyzer>(graph_, dom_);
+        own_loops->Run();
+        loops = own_loops.get();
+    }
+    RangeAnalysis ranges(graph_, dom_, loops);
+    ranges.Run();
+
+    for (auto* bb : graph_->GetRPO()) {
+        Instruction* inst = bb->GetFirstInst();
+        while (inst) {
+            Instruction* next = inst->GetNext();
+            if (auto* check = dyn_cast<BoundsCheckInst>(inst)) {
+                Instruction* index = check->GetIndex();
+                if (ranges.GetRangeAt(index, bb).min >= 0 && ranges.ProvesLess(index, check->GetLength(), bb)) {
+                    // the check passes its index through
+                    check->ReplaceAllUsesWith(index);
+                    bb->RemoveInst(check);
+                    check->DropInputs();
+                    graph_->FreeInstruction(check);
+                    removed_count_++;
+                    proven_count_++;
+                }
+            }
+            inst = next;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include "DeadCodeElimination.hpp"
+#include "Statistics.hpp"
+#include <vector>
+
+bool DeadCodeElimination::IsRoot(const Instruction* inst) {
+    switch (inst->GetOpcode()) {
+        case Opcode::Param:
+        case Opcode::Jump: case Opcode::If: case Opcode::BrCond: case Opcode::Br: case Opcode::Ret:
+        case Opcode::Call:
+        case Opcode::NullCheck: case Opcode::BoundsCheck: case Opcode::StoreArray:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void DeadCodeElimination::Run() {
+    PassStatsScope stats(graph_, "DeadCodeElimination");
+    removed_count_ = 0;
+    size_t blocks = graph_->RemoveUnreachableBlocks();
+    removed_blocks_ = blocks;
+    Mark();
+    Sweep();
+    Statistics::Count(graph_, "DeadCodeElimination", "removed_blocks", static_cast<int64_t>(blocks));
+}
+
+void DeadCodeElimination::Mark() {
+    live_.Reset(graph_, false);
+    std::vector<Instruction*> worklist;
+    auto mark = [&](Instruction* inst) {
+        if (!inst || live_[inst]) return;
+        live_[inst] = true;
+        worklist.push_back(inst);
+    };
+
+    for (auto& bb : graph_->GetBlocks()) {
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (IsRoot(inst)) mark(inst);
+        }
+    }
+    while (!worklist.empty()) {
+        Instruction* inst = worklist.back();
+        worklist.pop_back();
+        for (auto* input : inst->GetInputs()) mark(input);
+    }
+}
+
+void DeadCodeElimination::Sweep() {
+    std::vector<Instruction*> dead;
+    for (auto& bb : graph_->GetBlocks()) {
+        for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) {
+            if (!live_[inst]) dead.push_back(inst);
+        }
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (!live_[inst]) dead.push_back(inst);
+        }
+    }
+
+    // dead values may use each other, so detach them all before freeing
+    for (auto* inst : dead) inst->DropInputs();
+    for (auto* inst : dead) {
+        inst->GetBasicBlock()->RemoveInst(inst);
+        graph_->FreeInstruction(inst);
+    }
+    removed_count_ += dead.size();
+    Statistics::Count(graph_, "DeadCodeElimination", "removed", static_cast<int64_t>(dead.size()));
+}
@@ -1,89 +1,83 @@
 #include "DominatorAnalysis.hpp"
-#include <algorithm>
+#include "Statistics.hpp"
+#include <utility>
 
 void DominatorAnalysis::Run() {
-    idoms_.clear();
-    dominators_.clear();
-    
-    const auto& blocks_list = graph_->GetBlocks();
-    std::vector<BasicBlock*> blocks;
-    for(auto& ptr : blocks_list) blocks.push_back(ptr.get());
-    if (blocks.empty()) return;
+    PassStatsScope stats(graph_, "DominatorAnalysis");
+    idoms_.Reset(graph_, nullptr);
+    children_.Reset(graph_);
+    pre_.Reset(graph_, -1);
+    post_.Reset(graph_, -1);
+    preorder_.clear();
+
     BasicBlock* entry = graph_->GetEntryBlock();
+    if (!entry) return;
 
-    std::set<BasicBlock*> all_blocks_set(blocks.begin(), blocks.end());
-    
-    for (auto* bb : blocks) {
-        if (bb == entry) {
-            dominators_[bb] = {entry};
-        } else {
-            dominators_[bb] = all_blocks_set;
+    const auto& rpo = graph_->GetRPO();
+    BlockMap<int> rpo_index(graph_, -1);
+    for (size_t i = 0; i < rpo.size(); ++i) rpo_index[rpo[i]] = static_cast<int>(i);
+
+    auto intersect = [&](BasicBlock* a, BasicBlock* b) {
+        while (a != b) {
+            while (rpo_index[a] > rpo_index[b]) a = idoms_[a];
+            while (rpo_index[b] > rpo_index[a]) b = idoms_[b];
         }
-    }
+        return a;
+    };
 
+    idoms_[entry] = entry;
     bool changed = true;
     while (changed) {
         changed = false;
-        for (auto* bb : blocks) {
-            if (bb == entry) continue;
-
-            std::set<BasicBlock*> new_doms;
-            bool first = true;
-
-            if (bb->GetPreds().empty()) continue; 
-
+        for (size_t i = 1; i < rpo.size(); ++i) {
+            BasicBlock* bb = rpo[i];
+            BasicBlock* new_idom = nullptr;
             for (auto* pred : bb->GetPreds()) {
-                if (dominators_.find(pred) == dominators_.end()) continue;
-
-                if (first) {
-                    new_doms = dominators_[pred];
-                    first = false;
-                } else {
-                    std::set<BasicBlock*> intersection;
-                    std::set_intersection(new_doms.begin(), new_doms.end(),
-                                          dominators_[pred].begin(), dominators_[pred].end(),
-                                          std::inserter(intersection, intersection.begin()));
-                    new_doms = intersection;
-                }
+                if (!idoms_[pred]) continue;
+                new_idom = new_idom ? intersect(pred, new_idom) : pred;
             }
-
-            new_doms.insert(bb);
-
-            if (new_doms != dominators_[bb]) {
-                dominators_[bb] = new_doms;
+            if (idoms_[bb] != new_idom) {
+                idoms_[bb] = new_idom;
                 changed = true;
             }
         }
     }
-    
-    for (auto* bb : blocks) {
-        if (bb == entry) {
-            idoms_[bb] = nullptr;
-            continue;
-        }
-        
-        size_t target_size = dominators_[bb].size() - 1;
-        BasicBlock* idom = nullptr;
-        
-        for (auto* dom : dominators_[bb]) {
-            if (dom != bb && dominators_[dom].size() == target_size) {
-                idom = dom;
-                break;
-            }
+    idoms_[entry] = nullptr;
+
+    for (size_t i = 1; i < rpo.size(); ++i) {
+        children_[idoms_[rpo[i]]].push_back(rpo[i]);
+    }
+    NumberTree(entry);
+}
+
+void DominatorAnalysis::NumberTree(BasicBlock* root) {
+    int counter = 0;
+    std::vector<std::pair<BasicBlock*, size_t>> stack;
+    pre_[root] = counter++;
+    preorder_.push_back(root);
+    stack.emplace_back(root, 0);
+
+    while (!stack.empty()) {
+        auto& [bb, next_child] = stack.back();
+        const auto& children = children_[bb];
+        if (next_child < children.size()) {
+            BasicBlock* child = children[next_child++];
+            pre_[child] = counter++;
+            preorder_.push_back(child);
+            stack.emplace_back(child, 0);
+        } else {
+            post_[bb] = counter++;
+            stack.pop_back();
         }
-        idoms_[bb] = idom;
     }
 }
 
 BasicBlock* DominatorAnalysis::GetIdom(BasicBlock* bb) const {
-    auto it = idoms_.find(bb);
-    return (it != idoms_.end()) ? it->second : nullptr;
+    return idoms_.Get(bb);
 }
 
 bool DominatorAnalysis::Dominates(BasicBlock* dom, BasicBlock* node) const {
     if (!node || !dom) return false;
-
-    auto it = dominators_.find(node);
-    if (it == dominators_.end()) return false;
-    return it->second.count(dom);
-}
\ No newline at end of file
+    if (!IsReachable(dom) || !IsReachable(node)) return false;
+    return pre_.Get(dom) <= pre_.Get(node) && post_.Get(node) <= post_.Get(dom);
+}
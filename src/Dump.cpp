@@ -12,6 +12,7 @@ static std::string TypeToString(Type type) {
 static std::string OpcodeToString(Opcode opcode) {
     switch (opcode) {
         case Opcode::Add: return "add";
+        case Opcode::Sub: return "sub";
         case Opcode::Mul: return "mul";
         case Opcode::Cmp: return "cmp";
         case Opcode::Jump: return "jump";
@@ -22,6 +23,7 @@ static std::string OpcodeToString(Opcode opcode) {
         case Opcode::Param: return "param";
         case Opcode::Or: return "or";
         case Opcode::AShr: return "ashr";
+        case Opcode::Shl: return "shl";
         case Opcode::Call: return "call";
         case Opcode::NullCheck: return "null_check";
         case Opcode::BoundsCheck: return "bounds_check";
@@ -72,10 +74,9 @@ void ReturnInst::Dump() const {
 void PhiInst::Dump() const {
     std::cout << "v" << GetId() << TypeToString(GetType()) << " = "
               << OpcodeToString(GetOpcode()) << " ";
-    for (size_t i = 0; i < phi_inputs_.size(); ++i) {
-        auto& [from, value] = phi_inputs_[i];
-        std::cout << "[ BB<" << from->GetId() << ">, v" << value->GetId() << " ]";
-        if (i < phi_inputs_.size() - 1) {
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        std::cout << "[ BB<" << blocks_[i]->GetId() << ">, v" << GetInput(i)->GetId() << " ]";
+        if (i < blocks_.size() - 1) {
             std::cout << ", ";
         }
     }
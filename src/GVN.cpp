@@ -0,0 +1,90 @@
+#include "GVN.hpp"
+#include "AnalysisManager.hpp"
+#include "ConstantFolding.hpp"
+#include "Statistics.hpp"
+#include <functional>
+#include <utility>
+
+GVN::GVN(Graph* graph, AnalysisManager& am) : GVN(graph, &am.Get<DominatorAnalysis>()) {}
+
+size_t GVN::ValueKeyHash::operator()(const ValueKey& key) const {
+    size_t hash = std::hash<int>()(static_cast<int>(key.opcode));
+    auto mix = [&hash](size_t value) { hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2); };
+    mix(std::hash<int>()(static_cast<int>(key.type)));
+    mix(std::hash<int64_t>()(key.constant));
+    mix(std::hash<const Instruction*>()(key.lhs));
+    mix(std::hash<const Instruction*>()(key.rhs));
+    return hash;
+}
+
+bool GVN::MakeKey(const Instruction* inst, ValueKey& key) {
+    key = {inst->GetOpcode(), inst->GetType()};
+    if (auto* constant = dyn_cast<ConstantInst>(inst)) {
+        key.constant = GetConstantValue(constant);
+        return true;
+    }
+    if (!isa<BinaryInst>(inst)) return false;
+
+    key.lhs = inst->GetInput(0);
+    key.rhs = inst->GetInput(1);
+    switch (inst->GetOpcode()) {
+        case Opcode::Add: case Opcode::Mul: case Opcode::Or:
+            if (key.rhs->GetId() < key.lhs->GetId()) std::swap(key.lhs, key.rhs);
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+void GVN::Run() {
+    PassStatsScope stats(graph_, "GVN");
+    table_.clear();
+    removed_count_ = 0;
+    BasicBlock* entry = graph_->GetEntryBlock();
+    if (!entry || !dom_->IsReachable(entry)) return;
+
+    // (block, next child) pairs; each frame owns the keys its block added
+    std::vector<std::pair<BasicBlock*, size_t>> stack;
+    std::vector<std::vector<ValueKey>> scopes;
+    stack.emplace_back(entry, 0);
+    scopes.emplace_back();
+    VisitBlock(entry, scopes.back());
+
+    while (!stack.empty()) {
+        auto& [bb, next_child] = stack.back();
+        const auto& children = dom_->GetChildren(bb);
+        if (next_child < children.size()) {
+            BasicBlock* child = children[next_child++];
+            stack.emplace_back(child, 0);
+            scopes.emplace_back();
+            VisitBlock(child, scopes.back());
+        } else {
+            for (const auto& key : scopes.back()) table_.erase(key);
+            scopes.pop_back();
+            stack.pop_back();
+        }
+    }
+}
+
+void GVN::VisitBlock(BasicBlock* bb, std::vector<ValueKey>& scope) {
+    Instruction* inst = bb->GetFirstInst();
+    while (inst) {
+        Instruction* next = inst->GetNext();
+        ValueKey key;
+        if (MakeKey(inst, key)) {
+            auto [it, inserted] = table_.emplace(key, inst);
+            if (inserted) {
+                scope.push_back(key);
+            } else {
+                inst->ReplaceAllUsesWith(it->second);
+                bb->RemoveInst(inst);
+                inst->DropInputs();
+                graph_->FreeInstruction(inst);
+                removed_count_++;
+                Statistics::Count(graph_, "GVN", "removed");
+            }
+        }
+        inst = next;
+    }
+}
@@ -0,0 +1,187 @@
+#include "GraphCloner.hpp"
+#include "ConstantFolding.hpp"
+#include "InstVisitor.hpp"
+#include <functional>
+
+namespace {
+// Creates copies whose operands are already translated by the cloner.
+// Branch targets are the source ones; CloneBlocks moves them afterwards.
+class InstCloner : public InstVisitor<InstCloner, Instruction*> {
+public:
+    InstCloner(Graph* graph, const GraphCloner& cloner, BasicBlock* bb) : graph_(graph), cloner_(cloner), bb_(bb) {}
+
+    Instruction* VisitParam(ParameterInst* param) {
+        return graph_->CreateInstruction<ParameterInst>(param->GetType(), bb_);
+    }
+    Instruction* VisitConst(ConstantInst* c) {
+        return graph_->CreateInstruction<ConstantInst>(c->GetType(), bb_, c->GetValue());
+    }
+    Instruction* VisitBinary(BinaryInst* bin) {
+        return graph_->CreateInstruction<BinaryInst>(bin->GetOpcode(), bin->GetType(), bb_,
+            Operand(bin, 0), Operand(bin, 1));
+    }
+    Instruction* VisitJump(JumpInst* jump) {
+        return graph_->CreateInstruction<JumpInst>(bb_, jump->GetTarget());
+    }
+    Instruction* VisitIf(IfInst* branch) {
+        return graph_->CreateInstruction<IfInst>(bb_, Operand(branch, 0),
+            branch->GetTrueTarget(), branch->GetFalseTarget());
+    }
+    Instruction* VisitPhi(PhiInst* phi) {
+        return graph_->CreateInstruction<PhiInst>(phi->GetType(), bb_);
+    }
+    Instruction* VisitReturn(ReturnInst* ret) {
+        return graph_->CreateInstruction<ReturnInst>(bb_, ret->GetInputs().empty() ? nullptr : Operand(ret, 0));
+    }
+    Instruction* VisitCall(CallInst* call) {
+        std::vector<Instruction*> args;
+        for (auto* arg : call->GetInputs()) args.push_back(cloner_.Lookup(arg));
+        return graph_->CreateInstruction<CallInst>(call->GetType(), bb_, call->GetCallee(), args);
+    }
+    Instruction* VisitNullCheck(NullCheckInst* check) {
+        return graph_->CreateInstruction<NullCheckInst>(check->GetType(), bb_, Operand(check, 0));
+    }
+    Instruction* VisitBoundsCheck(BoundsCheckInst* check) {
+        return graph_->CreateInstruction<BoundsCheckInst>(check->GetType(), bb_, Operand(check, 0), Operand(check, 1));
+    }
+    Instruction* VisitLoadArray(LoadArrayInst* load) {
+        return graph_->CreateInstruction<LoadArrayInst>(load->GetType(), bb_, Operand(load, 0), Operand(load, 1));
+    }
+    Instruction* VisitStoreArray(StoreArrayInst* store) {
+        return graph_->CreateInstruction<StoreArrayInst>(store->GetType(), bb_, Operand(store, 0),
+            Operand(store, 1), Operand(store, 2));
+    }
+    Instruction* VisitInstruction(Instruction*) {
+        assert(false && "instruction cannot be cloned");
+        return nullptr;
+    }
+
+private:
+    Graph* graph_;
+    const GraphCloner& cloner_;
+    BasicBlock* bb_;
+
+    Instruction* Operand(Instruction* inst, size_t i) const { return cloner_.Lookup(inst->GetInput(i)); }
+};
+
+bool IsTerminator(const Instruction* inst) {
+    return inst && (isa<JumpInst>(inst) || isa<IfInst>(inst) || isa<ReturnInst>(inst));
+}
+} // namespace
+
+size_t GraphCloner::ConstantKeyHash::operator()(const ConstantKey& key) const {
+    return std::hash<int64_t>()(key.value) ^ (std::hash<int>()(static_cast<int>(key.type)) << 1);
+}
+
+GraphCloner::GraphCloner(Graph* source, Graph* target)
+    : source_(source), target_(target), values_(source, nullptr), blocks_(source, nullptr) {}
+
+void GraphCloner::Reset() {
+    values_.Reset(source_, nullptr);
+    blocks_.Reset(source_, nullptr);
+    constants_.clear();
+    constants_indexed_ = false;
+}
+
+Instruction* GraphCloner::CloneInstruction(Instruction* inst, BasicBlock* bb) {
+    Instruction* clone = InstCloner(target_, *this, bb).Visit(inst);
+    values_[inst] = clone;
+    return clone;
+}
+
+void GraphCloner::CloneBlocks(const std::vector<BasicBlock*>& blocks, bool link_exits) {
+    CreateBlocks(blocks);
+    CopyBlocks(blocks, link_exits);
+}
+
+void GraphCloner::CloneGraph() {
+    assert(target_ != source_ && !target_->GetEntryBlock());
+    const auto& rpo = source_->GetRPO();
+    std::vector<BasicBlock*> blocks(rpo.begin(), rpo.end());
+    CreateBlocks(blocks);
+    target_->SetEntryBlock(GetClone(source_->GetEntryBlock()));
+    CopyBlocks(blocks, false);
+}
+
+void GraphCloner::CreateBlocks(const std::vector<BasicBlock*>& blocks) {
+    for (auto* bb : blocks) blocks_[bb] = target_->CreateNewBasicBlock();
+}
+
+void GraphCloner::CopyBlocks(const std::vector<BasicBlock*>& blocks, bool link_exits) {
+    BlockMap<bool> copied(source_, false);
+    for (auto* bb : blocks) copied[bb] = true;
+    auto target = [&](BasicBlock* bb) { return copied.Get(bb) ? GetClone(bb) : bb; };
+
+    std::vector<PhiInst*> phis;
+    for (auto* bb : blocks) {
+        BasicBlock* copy = GetClone(bb);
+        for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) {
+            copy->AppendInst(CloneInstruction(inst, copy));
+            phis.push_back(cast<PhiInst>(inst));
+        }
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (isa<ParameterInst>(inst) && GetClone(inst)) continue;
+            if (auto* constant = dyn_cast<ConstantInst>(inst)) {
+                values_[inst] = GetSharedConstant(constant);
+                continue;
+            }
+            Instruction* clone = CloneInstruction(inst, copy);
+            if (auto* jump = dyn_cast<JumpInst>(clone)) {
+                jump->ReplaceTarget(target(jump->GetTarget()));
+            } else if (auto* branch = dyn_cast<IfInst>(clone)) {
+                branch->ReplaceTargets(target(branch->GetTrueTarget()), target(branch->GetFalseTarget()));
+            }
+            copy->AppendInst(clone);
+        }
+    }
+
+    for (auto* phi : phis) {
+        auto* clone = cast<PhiInst>(GetClone(phi));
+        for (auto [from, value] : phi->GetPhiInputs()) {
+            BasicBlock* mapped_from = GetClone(from);
+            clone->AddPhiInput(mapped_from ? mapped_from : from, Lookup(value));
+        }
+    }
+
+    for (auto* bb : blocks) {
+        for (auto* succ : bb->GetSuccs()) {
+            if (copied.Get(succ)) {
+                GetClone(bb)->LinkTo(GetClone(succ));
+            } else if (link_exits) {
+                GetClone(bb)->LinkTo(succ);
+            }
+        }
+    }
+}
+
+Instruction* GraphCloner::GetSharedConstant(ConstantInst* constant) {
+    BasicBlock* entry = target_->GetEntryBlock();
+    if (!constants_indexed_) {
+        constants_indexed_ = true;
+        for (auto* inst = entry->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (auto* existing = dyn_cast<ConstantInst>(inst)) {
+                constants_.emplace(ConstantKey{existing->GetType(), GetConstantValue(existing)}, existing);
+            }
+        }
+    }
+    ConstantKey key{constant->GetType(), GetConstantValue(constant)};
+    auto it = constants_.find(key);
+    if (it != constants_.end()) return it->second;
+
+    auto* clone = target_->CreateInstruction<ConstantInst>(constant->GetType(), entry, constant->GetValue());
+    Instruction* last = entry->GetLastInst();
+    if (IsTerminator(last)) {
+        entry->InsertBefore(last, clone);
+    } else {
+        entry->AppendInst(clone);
+    }
+    constants_.emplace(key, clone);
+    return clone;
+}
+
+std::unique_ptr<Graph> Graph::Clone() {
+    auto clone = std::make_unique<Graph>();
+    GraphCloner cloner(this, clone.get());
+    cloner.CloneGraph();
+    return clone;
+}
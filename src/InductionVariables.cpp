@@ -0,0 +1,79 @@
+#include "InductionVariables.hpp"
+#include "ConstantFolding.hpp"
+#include "Statistics.hpp"
+
+void InductionVariableAnalysis::Run() {
+    PassStatsScope stats(graph_, "InductionVariableAnalysis");
+    ivs_.Reset(graph_);
+    basics_.clear();
+
+    for (auto& loop : loops_->GetLoops()) FindBasicVariables(loop.get());
+    // operands come before their users in RPO, phis are already known
+    for (auto* bb : graph_->GetRPO()) {
+        if (!loops_->GetLoopFor(bb)) continue;
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (auto* bin = dyn_cast<BinaryInst>(inst)) FindDerivedVariable(bin);
+        }
+    }
+    Statistics::Count(graph_, "InductionVariableAnalysis", "basic_ivs", static_cast<int64_t>(basics_.size()));
+}
+
+void InductionVariableAnalysis::FindBasicVariables(Loop* loop) {
+    if (loop->back_edges.size() != 1) return;
+    BasicBlock* latch = loop->back_edges.front();
+
+    for (auto* inst = loop->header->GetFirstPhi(); inst; inst = inst->GetNext()) {
+        auto* phi = cast<PhiInst>(inst);
+        if (phi->GetInputs().size() != 2) continue;
+        Instruction* init = nullptr;
+        Instruction* next = nullptr;
+        for (auto [from, value] : phi->GetPhiInputs()) {
+            if (from == latch) {
+                next = value;
+            } else if (!loop->Contains(from)) {
+                init = value;
+            }
+        }
+
+        auto* update = dyn_cast<BinaryInst>(next);
+        if (!init || !update || update->GetOpcode() != Opcode::Add) continue;
+        if (update->GetType() != phi->GetType() || !loop->Contains(update->GetBasicBlock())) continue;
+        Instruction* other = update->GetInput(0) == phi ? update->GetInput(1) : update->GetInput(0);
+        auto* step = dyn_cast<ConstantInst>(other);
+        if (!step || (update->GetInput(0) != phi && update->GetInput(1) != phi)) continue;
+
+        basics_.push_back(std::make_unique<BasicInductionVariable>(
+            BasicInductionVariable{loop, phi, init, update, GetConstantValue(step)}));
+        ivs_[phi] = {basics_.back().get(), 1, 0};
+    }
+}
+
+void InductionVariableAnalysis::FindDerivedVariable(BinaryInst* bin) {
+    Opcode opcode = bin->GetOpcode();
+    if (opcode != Opcode::Add && opcode != Opcode::Mul && opcode != Opcode::Shl) return;
+
+    const InductionVariable* iv = Get(bin->GetInput(0));
+    auto* constant = dyn_cast<ConstantInst>(bin->GetInput(1));
+    if ((!iv || !constant) && opcode != Opcode::Shl) {
+        iv = Get(bin->GetInput(1));
+        constant = dyn_cast<ConstantInst>(bin->GetInput(0));
+    }
+    if (!iv || !constant) return;
+    const BasicInductionVariable* basic = iv->basic;
+    if (bin->GetType() != basic->phi->GetType() || !basic->loop->Contains(bin->GetBasicBlock())) return;
+
+    Type type = bin->GetType();
+    int64_t value = GetConstantValue(constant);
+    if (opcode == Opcode::Shl) {
+        // iv << c scales by 2^c
+        value = *FoldBinaryOp(Opcode::Shl, type, 1, value);
+    }
+    InductionVariable derived = *iv;
+    if (opcode == Opcode::Add) {
+        derived.offset = *FoldBinaryOp(Opcode::Add, type, iv->offset, value);
+    } else {
+        derived.scale = *FoldBinaryOp(Opcode::Mul, type, iv->scale, value);
+        derived.offset = *FoldBinaryOp(Opcode::Mul, type, iv->offset, value);
+    }
+    ivs_[bin] = derived;
+}
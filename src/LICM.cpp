@@ -0,0 +1,87 @@
+#include "LICM.hpp"
+#include "AnalysisManager.hpp"
+#include "LoopUtils.hpp"
+#include "Statistics.hpp"
+
+LICM::LICM(Graph* graph, AnalysisManager& am)
+    : LICM(graph, &am.Get<DominatorAnalysis>(), &am.Get<LoopAnalyzer>()) {}
+
+void LICM::Run() {
+    PassStatsScope stats(graph_, "LICM");
+    if (!graph_->GetEntryBlock()) return;
+
+    for (auto* loop : LoopUtils::GetLoopsInnermostFirst(loops_->GetRootLoop())) {
+        if (!LoopUtils::GetPreheader(loop)) {
+            LoopUtils::EnsurePreheader(graph_, loop);
+            preheader_count_++;
+        }
+    }
+    if (preheader_count_) {
+        Statistics::Count(graph_, "LICM", "preheaders", static_cast<int64_t>(preheader_count_));
+        dom_->Run();
+        loops_->Run();
+    }
+
+    for (auto* loop : LoopUtils::GetLoopsInnermostFirst(loops_->GetRootLoop())) {
+        BasicBlock* preheader = LoopUtils::GetPreheader(loop);
+        if (preheader) HoistInvariants(loop, preheader);
+    }
+}
+
+void LICM::HoistInvariants(Loop* loop, BasicBlock* preheader) {
+    bool may_reorder_checks = true;
+    for (auto* bb : graph_->GetRPO()) {
+        if (!loop->Contains(bb)) continue;
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            switch (inst->GetOpcode()) {
+                case Opcode::Call: case Opcode::StoreArray: case Opcode::BoundsCheck:
+                    may_reorder_checks = false;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    for (auto* bb : graph_->GetRPO()) {
+        if (!loop->Contains(bb)) continue;
+        Instruction* inst = bb->GetFirstInst();
+        while (inst) {
+            Instruction* next = inst->GetNext();
+            bool hoist = false;
+            if (isa<ConstantInst>(inst) || isa<BinaryInst>(inst)) {
+                hoist = IsInvariant(inst, loop);
+            } else if (isa<NullCheckInst>(inst)) {
+                hoist = may_reorder_checks && IsInvariant(inst, loop) && RunsEveryIteration(bb, loop);
+                // a check left behind must stay ahead of the ones after it
+                may_reorder_checks = hoist;
+            }
+            if (hoist) {
+                bb->RemoveInst(inst);
+                preheader->InsertBefore(preheader->GetLastInst(), inst);
+                hoisted_count_++;
+                Statistics::Count(graph_, "LICM", "hoisted");
+            }
+            inst = next;
+        }
+    }
+}
+
+bool LICM::IsInvariant(const Instruction* inst, const Loop* loop) const {
+    for (auto* input : inst->GetInputs()) {
+        if (loop->Contains(input->GetBasicBlock())) return false;
+    }
+    return true;
+}
+
+bool LICM::RunsEveryIteration(BasicBlock* bb, const Loop* loop) const {
+    for (auto* latch : loop->back_edges) {
+        if (!dom_->Dominates(bb, latch)) return false;
+    }
+    for (auto* member : loop->blocks) {
+        for (auto* succ : member->GetSuccs()) {
+            if (!loop->Contains(succ) && !dom_->Dominates(bb, member)) return false;
+        }
+    }
+    return true;
+}
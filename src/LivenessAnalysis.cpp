@@ -1,4 +1,5 @@
 #include "LivenessAnalysis.hpp"
+#include "Statistics.hpp"
 #include <algorithm>
 
 static bool IsTrackable(Instruction* inst) {
@@ -19,17 +20,18 @@ void LivenessAnalysis::NumberInstructions() {
 }
 
 void LivenessAnalysis::BuildIntervals() {
-    intervals_.clear();
-    live_in_.clear();
+    intervals_.Reset(graph_);
+    live_in_.Reset(graph_);
+    live_out_.Reset(graph_);
 
-    std::map<BasicBlock*, BasicBlock*> loop_headers;
-    std::map<BasicBlock*, int> bb_pos;
-    for(size_t i = 0; i < linear_blocks_.size(); ++i) bb_pos[linear_blocks_[i]] = i;
+    BlockMap<BasicBlock*> loop_headers(graph_, nullptr);
+    BlockMap<int> bb_pos(graph_, -1);
+    for(size_t i = 0; i < linear_blocks_.size(); ++i) bb_pos[linear_blocks_[i]] = static_cast<int>(i);
 
     for (auto* bb : linear_blocks_) {
         for (auto* succ : bb->GetSuccs()) {
-            if (bb_pos.count(succ) && bb_pos[succ] <= bb_pos[bb]) {
-                if (loop_headers.find(succ) == loop_headers.end() || 
+            if (bb_pos[succ] >= 0 && bb_pos[succ] <= bb_pos[bb]) {
+                if (loop_headers[succ] == nullptr || 
                     bb_pos[bb] > bb_pos[loop_headers[succ]]) {
                     loop_headers[succ] = bb;
                 }
@@ -52,9 +54,8 @@ void LivenessAnalysis::BuildIntervals() {
 
         std::set<int> live;
         for (auto* succ : b->GetSuccs()) {
-             if (live_in_.count(succ)) {
-                 live.insert(live_in_[succ].begin(), live_in_[succ].end());
-             }
+             const auto& succ_live = live_in_.Get(succ);
+             live.insert(succ_live.begin(), succ_live.end());
 
              for (auto* inst = succ->GetFirstPhi(); inst; inst = inst->GetNext()) {
                  auto* phi = static_cast<PhiInst*>(inst);
@@ -99,7 +100,7 @@ void LivenessAnalysis::BuildIntervals() {
             }
         }
 
-        if (loop_headers.count(b)) {
+        if (loop_headers[b]) {
             BasicBlock* loop_end = loop_headers[b];
             Instruction* end_inst = loop_end->GetLastInst() ? loop_end->GetLastInst() : loop_end->GetLastPhi();
             int loop_end_pos = end_inst ? end_inst->GetLifePosition() + 2 : b_to;
@@ -114,6 +115,7 @@ void LivenessAnalysis::BuildIntervals() {
 }
 
 void LivenessAnalysis::Run() {
+    PassStatsScope stats(graph_, "LivenessAnalysis");
     if (linear_blocks_.empty() && graph_->GetEntryBlock() != nullptr) {
         std::cerr << "Warning: Linear order is empty!" << std::endl;
     }
@@ -1,15 +1,14 @@
 #include "LoopAnalyzer.hpp"
+#include "Statistics.hpp"
 #include <algorithm>
 #include <iostream>
 
 void LoopAnalyzer::Run() {
+    PassStatsScope stats(graph_, "LoopAnalyzer");
     all_loops_.clear();
-    color_.clear();
+    color_.Reset(graph_, Color::WHITE);
+    block_loop_.Reset(graph_, nullptr);
     loop_counter_ = 0;
-    
-    for (const auto& block_ptr : graph_->GetBlocks()) {
-        color_[block_ptr.get()] = Color::WHITE;
-    }
 
     BasicBlock* entry = graph_->GetEntryBlock();
     if (entry) {
@@ -22,6 +21,7 @@ void LoopAnalyzer::Run() {
     }
 
     BuildLoopTree();
+    Statistics::Count(graph_, "LoopAnalyzer", "loops", static_cast<int64_t>(all_loops_.size()));
 }
 
 void LoopAnalyzer::DFSVisit(BasicBlock* u, std::stack<BasicBlock*>& stack) {
@@ -111,6 +111,15 @@ void LoopAnalyzer::BuildLoopTree() {
             root_loop_->sub_loops.push_back(loop);
         }
     }
+
+    // outer loops first, so every block ends up mapped to its innermost loop
+    for (auto it = sorted_loops.rbegin(); it != sorted_loops.rend(); ++it) {
+        Loop* loop = *it;
+        loop->depth = loop->parent_loop->depth + 1;
+        for (auto* bb : loop->blocks) {
+            block_loop_[bb] = loop;
+        }
+    }
 }
 
 void LoopAnalyzer::Dump() const {
@@ -0,0 +1,180 @@
+#include "LoopPredication.hpp"
+#include "AnalysisManager.hpp"
+#include "ConstantFolding.hpp"
+#include "GraphCloner.hpp"
+#include "LoopUtils.hpp"
+#include "Statistics.hpp"
+#include <set>
+
+LoopPredication::LoopPredication(Graph* graph, AnalysisManager& am)
+    : LoopPredication(graph, &am.Get<DominatorAnalysis>(), &am.Get<LoopAnalyzer>()) {}
+
+void LoopPredication::Run() {
+    PassStatsScope stats(graph_, "LoopPredication");
+    RangeAnalysis ranges(graph_, dom_, loops_);
+    ranges.Run();
+
+    // everything is decided before the first copy invalidates the analyses
+    std::vector<PredicatedLoop> candidates;
+    for (auto& loop : loops_->GetLoops()) {
+        PredicatedLoop info;
+        if (Analyze(loop.get(), ranges, info)) candidates.push_back(std::move(info));
+    }
+    for (const auto& info : candidates) {
+        Version(info);
+        versioned_count_++;
+        Statistics::Count(graph_, "LoopPredication", "versioned");
+        Statistics::Count(graph_, "LoopPredication", "checks_removed", static_cast<int64_t>(info.checks.size()));
+    }
+}
+
+bool LoopPredication::Analyze(Loop* loop, const RangeAnalysis& ranges, PredicatedLoop& info) const {
+    if (!loop->sub_loops.empty() || loop->back_edges.size() != 1) return false;
+    info.loop = loop;
+    info.preheader = LoopUtils::GetPreheader(loop);
+    if (!info.preheader) return false;
+
+    BasicBlock* header = loop->header;
+    auto* branch = dyn_cast<IfInst>(header->GetLastInst());
+    if (!branch) return false;
+    bool continue_on_true = loop->Contains(branch->GetTrueTarget());
+    info.exit = continue_on_true ? branch->GetFalseTarget() : branch->GetTrueTarget();
+    BasicBlock* body_entry = continue_on_true ? branch->GetTrueTarget() : branch->GetFalseTarget();
+    if (loop->Contains(info.exit) || info.exit->GetPreds().size() != 1) return false;
+    for (auto* bb : graph_->GetRPO()) {
+        if (!loop->Contains(bb)) continue;
+        for (auto* succ : bb->GetSuccs()) {
+            if (bb != header && !loop->Contains(succ)) return false;
+        }
+        info.blocks.push_back(bb);
+    }
+
+    // iv <= bound stays in the loop on true, bound <= iv leaves it
+    auto* cond = dyn_cast<BinaryInst>(branch->GetInput(0));
+    if (!cond || cond->GetOpcode() != Opcode::Cmp) return false;
+    bool strict = !continue_on_true;
+    Instruction* iv_value = cond->GetInput(strict ? 1 : 0);
+    info.bound = cond->GetInput(strict ? 0 : 1);
+    const auto& ivs = ranges.GetInductionVariables();
+    const InductionVariable* iv = ivs.Get(iv_value);
+    if (!iv || iv->basic->phi != iv_value || iv->basic->loop != loop || iv->basic->step <= 0) return false;
+    auto* init = dyn_cast<ConstantInst>(iv->basic->init);
+    if (!init || loop->Contains(info.bound->GetBasicBlock())) return false;
+    // the variable must not wrap, or it would not stay between init and bound
+    int64_t start = GetConstantValue(init);
+    if (ranges.GetRange(iv_value).min < start) return false;
+
+    Type type = iv_value->GetType();
+    ValueRange full = ValueRange::Full(type);
+    // a check the header runs also runs on the exiting test, which the
+    // guard does not cover, so only checks behind the body entry qualify
+    for (auto* bb : info.blocks) {
+        if (!dom_->Dominates(body_entry, bb)) continue;
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            auto* check = dyn_cast<BoundsCheckInst>(inst);
+            if (!check || loop->Contains(check->GetLength()->GetBasicBlock())) continue;
+            const InductionVariable* index = ivs.Get(check->GetIndex());
+            if (!index || index->basic != iv->basic || index->scale != 1) continue;
+            if (check->GetIndex()->GetType() != type || check->GetLength()->GetType() != type) continue;
+            if (ranges.GetRangeAt(check->GetIndex(), bb).min >= 0 &&
+                ranges.ProvesLess(check->GetIndex(), check->GetLength(), bb)) {
+                continue;
+            }
+            int64_t first = 0;
+            if (__builtin_add_overflow(start, index->offset, &first) || first < 0 || first > full.max) continue;
+            int64_t slack = index->offset - (strict ? 1 : 0);
+            info.checks.push_back({check, slack});
+        }
+    }
+    return !info.checks.empty();
+}
+
+// Or of the conditions under which one of the checks could fail:
+// length <= bound + slack, or bound + slack wrapping around.
+Instruction* LoopPredication::BuildGuard(const PredicatedLoop& info) {
+    BasicBlock* preheader = info.preheader;
+    Instruction* before = preheader->GetLastInst();
+    Type type = info.bound->GetType();
+    ValueRange full = ValueRange::Full(type);
+
+    auto insert = [&](Instruction* inst) {
+        preheader->InsertBefore(before, inst);
+        return inst;
+    };
+    auto constant = [&](int64_t value) {
+        return insert(graph_->CreateInstruction<ConstantInst>(type, preheader, MakeConstantValue(type, value)));
+    };
+    auto binary = [&](Opcode opcode, Type result, Instruction* lhs, Instruction* rhs) {
+        return insert(graph_->CreateInstruction<BinaryInst>(opcode, result, preheader, lhs, rhs));
+    };
+
+    Instruction* fails = nullptr;
+    auto add_failure = [&](Instruction* flag) {
+        fails = fails ? binary(Opcode::Or, Type::int32, fails, flag) : flag;
+    };
+    std::set<std::pair<Instruction*, int64_t>> seen;
+    for (const auto& predicated : info.checks) {
+        Instruction* length = predicated.check->GetLength();
+        int64_t slack = predicated.slack;
+        if (!seen.emplace(length, slack).second) continue;
+
+        Instruction* last = slack == 0 ? info.bound : binary(Opcode::Add, type, info.bound, constant(slack));
+        add_failure(binary(Opcode::Cmp, Type::int32, length, last));
+        if (slack > 0) {
+            // max - slack < bound
+            add_failure(binary(Opcode::Cmp, Type::int32, constant(full.max - slack + 1), info.bound));
+        }
+    }
+    return fails;
+}
+
+void LoopPredication::Version(const PredicatedLoop& info) {
+    BasicBlock* header = info.loop->header;
+    BasicBlock* preheader = info.preheader;
+    GraphCloner cloner(graph_, graph_);
+    cloner.CloneBlocks(info.blocks, true);
+    BasicBlock* slow_header = cloner.GetClone(header);
+
+    // both versions leave through the exit block, so values used after
+    // the loop need a phi there
+    std::set<Instruction*> exit_phis;
+    for (auto* phi = info.exit->GetFirstPhi(); phi; phi = phi->GetNext()) {
+        Instruction* value = cast<PhiInst>(phi)->GetPhiInputs()[0].second;
+        cast<PhiInst>(phi)->AddPhiInput(slow_header, cloner.Lookup(value));
+        exit_phis.insert(phi);
+    }
+    for (auto* bb : info.blocks) {
+        std::vector<Instruction*> insts;
+        for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) insts.push_back(inst);
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) insts.push_back(inst);
+        for (auto* inst : insts) {
+            std::set<Instruction*> outside;
+            for (auto* user : inst->GetUsers()) {
+                if (!info.loop->Contains(user->GetBasicBlock()) && !exit_phis.count(user)) outside.insert(user);
+            }
+            if (outside.empty()) continue;
+            auto* merge = graph_->CreateInstruction<PhiInst>(inst->GetType(), info.exit);
+            info.exit->AppendInst(merge);
+            merge->AddPhiInput(header, inst);
+            merge->AddPhiInput(slow_header, cloner.GetClone(inst));
+            for (auto* user : outside) user->ReplaceInput(inst, merge);
+        }
+    }
+
+    Instruction* fails = BuildGuard(info);
+    Instruction* jump = preheader->GetLastInst();
+    preheader->ReplaceSucc(header, slow_header);
+    preheader->RemoveInst(jump);
+    graph_->FreeInstruction(jump);
+    preheader->AppendInst(graph_->CreateInstruction<IfInst>(preheader, fails, slow_header, header));
+    preheader->LinkTo(header);
+
+    for (const auto& predicated : info.checks) {
+        BoundsCheckInst* check = predicated.check;
+        check->ReplaceAllUsesWith(check->GetIndex());
+        check->GetBasicBlock()->RemoveInst(check);
+        check->DropInputs();
+        graph_->FreeInstruction(check);
+        removed_count_++;
+    }
+}
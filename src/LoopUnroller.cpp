@@ -0,0 +1,260 @@
+#include "LoopUnroller.hpp"
+#include "AnalysisManager.hpp"
+#include "ConstantFolding.hpp"
+#include "LoopUtils.hpp"
+#include "Statistics.hpp"
+
+LoopUnroller::LoopUnroller(Graph* graph, AnalysisManager& am)
+    : LoopUnroller(graph, &am.Get<LoopAnalyzer>()) {}
+
+void LoopUnroller::Run() {
+    PassStatsScope stats(graph_, "LoopUnroller");
+    InductionVariableAnalysis ivs(graph_, loops_);
+    ivs.Run();
+
+    // innermost loops are disjoint, so unrolling one leaves the others intact
+    std::vector<CountedLoop> counted;
+    for (auto& loop : loops_->GetLoops()) {
+        CountedLoop info;
+        if (Analyze(loop.get(), ivs, info)) counted.push_back(std::move(info));
+    }
+
+    for (const auto& info : counted) {
+        auto trips = static_cast<size_t>(info.trip_count);
+        if (info.trip_count <= max_full_trip_count_ && trips * info.size <= max_unrolled_size_) {
+            FullyUnroll(info);
+            fully_unrolled_++;
+            Statistics::Count(graph_, "LoopUnroller", "fully_unrolled");
+        } else if (factor_ > 1 && trips >= factor_ && info.size * factor_ <= max_unrolled_size_ &&
+                   StaysInRange(info, info.trip_count + static_cast<int64_t>(factor_) - 1)) {
+            PartiallyUnroll(info);
+            partially_unrolled_++;
+            Statistics::Count(graph_, "LoopUnroller", "partially_unrolled");
+        }
+    }
+}
+
+bool LoopUnroller::Analyze(Loop* loop, const InductionVariableAnalysis& ivs, CountedLoop& info) const {
+    if (!loop->sub_loops.empty() || loop->back_edges.size() != 1) return false;
+    info.loop = loop;
+    info.latch = loop->back_edges.front();
+    info.preheader = LoopUtils::GetPreheader(loop);
+    if (!info.preheader || info.latch == loop->header || !isa<JumpInst>(info.latch->GetLastInst())) return false;
+
+    BasicBlock* header = loop->header;
+    info.branch = dyn_cast<IfInst>(header->GetLastInst());
+    if (!info.branch) return false;
+    info.continue_on_true = loop->Contains(info.branch->GetTrueTarget());
+    info.body_entry = info.continue_on_true ? info.branch->GetTrueTarget() : info.branch->GetFalseTarget();
+    info.exit = info.continue_on_true ? info.branch->GetFalseTarget() : info.branch->GetTrueTarget();
+    if (loop->Contains(info.exit) || !loop->Contains(info.body_entry)) return false;
+
+    for (auto* bb : graph_->GetRPO()) {
+        if (!loop->Contains(bb)) continue;
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) info.size++;
+        if (bb == header) continue;
+        for (auto* succ : bb->GetSuccs()) {
+            if (!loop->Contains(succ)) return false;
+        }
+        info.body.push_back(bb);
+    }
+
+    info.cond = dyn_cast<BinaryInst>(info.branch->GetInput(0));
+    if (!info.cond || info.cond->GetOpcode() != Opcode::Cmp) return false;
+    for (size_t side = 0; side < 2; ++side) {
+        const InductionVariable* iv = ivs.Get(info.cond->GetInput(side));
+        auto* limit = dyn_cast<ConstantInst>(info.cond->GetInput(1 - side));
+        if (!iv || !limit || iv->basic->phi != info.cond->GetInput(side) || iv->basic->loop != loop) continue;
+        info.iv = iv->basic;
+        info.limit = limit;
+        info.iv_on_left = side == 0;
+    }
+    if (!info.iv || !isa<ConstantInst>(info.iv->init)) return false;
+
+    auto users = info.cond->GetUsers();
+    info.skip_cond = std::next(users.begin()) == users.end() && *users.begin() == info.branch;
+    info.trip_count = ComputeTripCount(info);
+    return info.trip_count >= 0;
+}
+
+bool LoopUnroller::IsTaken(const CountedLoop& info, int64_t iv_value) const {
+    Type type = info.iv->phi->GetType();
+    int64_t limit = GetConstantValue(cast<ConstantInst>(info.limit));
+    int64_t lhs = info.iv_on_left ? iv_value : limit;
+    int64_t rhs = info.iv_on_left ? limit : iv_value;
+    return (*FoldBinaryOp(Opcode::Cmp, type, lhs, rhs) != 0) == info.continue_on_true;
+}
+
+int64_t LoopUnroller::ComputeTripCount(const CountedLoop& info) const {
+    Type type = info.iv->phi->GetType();
+    int64_t value = GetConstantValue(cast<ConstantInst>(info.iv->init));
+    for (int64_t count = 0; count <= kMaxTripCount; ++count) {
+        if (!IsTaken(info, value)) return count;
+        value = *FoldBinaryOp(Opcode::Add, type, value, info.iv->step);
+    }
+    return -1;
+}
+
+// The unrolled header tests the value iterations - 1 steps ahead, which is
+// only the same as testing every value in between while nothing wraps.
+bool LoopUnroller::StaysInRange(const CountedLoop& info, int64_t iterations) const {
+    Type type = info.iv->phi->GetType();
+    int64_t step = info.iv->step;
+    int64_t value = GetConstantValue(cast<ConstantInst>(info.iv->init));
+    for (int64_t i = 0; i < iterations; ++i) {
+        int64_t next = *FoldBinaryOp(Opcode::Add, type, value, step);
+        if (step > 0 ? next < value : next > value) return false;
+        value = next;
+    }
+    return true;
+}
+
+Instruction* LoopUnroller::Lookup(Instruction* inst) const {
+    return cloner_.Lookup(inst);
+}
+
+void LoopUnroller::StartIterations(const CountedLoop& info) {
+    cloner_.Reset();
+    for (auto* phi = info.loop->header->GetFirstPhi(); phi; phi = phi->GetNext()) {
+        for (auto [from, value] : cast<PhiInst>(phi)->GetPhiInputs()) {
+            if (from == info.preheader) cloner_.Map(phi, value);
+        }
+    }
+}
+
+// Header instructions are copied with the current phi values; the branch
+// is dropped, the caller decides where the copy continues.
+void LoopUnroller::CopyHeader(const CountedLoop& info, BasicBlock* into) {
+    auto* before = dyn_cast<JumpInst>(into->GetLastInst());
+    for (auto* inst = info.loop->header->GetFirstInst(); inst; inst = inst->GetNext()) {
+        if (inst == info.branch || (inst == info.cond && info.skip_cond)) continue;
+        Instruction* clone = cloner_.CloneInstruction(inst, into);
+        if (before) {
+            into->InsertBefore(before, clone);
+        } else {
+            into->AppendInst(clone);
+        }
+    }
+}
+
+// Copies the body of one iteration after tail, which holds the header copy
+// of that iteration. Returns the copied latch, still jumping to the header.
+BasicBlock* LoopUnroller::CopyBody(const CountedLoop& info, BasicBlock* tail) {
+    cloner_.Map(info.loop->header, tail);
+    cloner_.CloneBlocks(info.body);
+    return cloner_.GetClone(info.latch);
+}
+
+void LoopUnroller::AdvancePhis(const CountedLoop& info) {
+    std::vector<Instruction*> next;
+    for (auto* phi = info.loop->header->GetFirstPhi(); phi; phi = phi->GetNext()) {
+        for (auto [from, value] : cast<PhiInst>(phi)->GetPhiInputs()) {
+            if (from == info.latch) next.push_back(Lookup(value));
+        }
+    }
+    size_t i = 0;
+    for (auto* phi = info.loop->header->GetFirstPhi(); phi; phi = phi->GetNext()) cloner_.Map(phi, next[i++]);
+}
+
+// from is the preheader or a copied latch; either way it ends in a jump to
+// the original header, but only the preheader has the edge.
+void LoopUnroller::Retarget(const CountedLoop& info, BasicBlock* from, BasicBlock* to) {
+    if (from == info.preheader) {
+        from->ReplaceSucc(info.loop->header, to);
+        return;
+    }
+    cast<JumpInst>(from->GetLastInst())->ReplaceTarget(to);
+    from->LinkTo(to);
+}
+
+void LoopUnroller::FullyUnroll(const CountedLoop& info) {
+    BasicBlock* header = info.loop->header;
+    StartIterations(info);
+    BasicBlock* tail = info.preheader;
+    for (int64_t i = 0; i < info.trip_count; ++i) {
+        CopyHeader(info, tail);
+        BasicBlock* latch = CopyBody(info, tail);
+        Retarget(info, tail, cloner_.GetClone(info.body_entry));
+        tail = latch;
+        AdvancePhis(info);
+    }
+
+    // the last header copy computes the exit values and leaves the loop
+    CopyHeader(info, tail);
+    for (auto* phi = info.exit->GetFirstPhi(); phi; phi = phi->GetNext()) {
+        cast<PhiInst>(phi)->ReplaceBlock(header, tail);
+    }
+    header->RemoveEdgeTo(info.exit);
+    Retarget(info, tail, info.exit);
+
+    std::vector<Instruction*> header_values;
+    for (auto* phi = header->GetFirstPhi(); phi; phi = phi->GetNext()) header_values.push_back(phi);
+    for (auto* inst = header->GetFirstInst(); inst; inst = inst->GetNext()) header_values.push_back(inst);
+    for (auto* inst : header_values) {
+        if (Lookup(inst) != inst) inst->ReplaceAllUsesWith(Lookup(inst));
+    }
+    graph_->RemoveUnreachableBlocks();
+}
+
+// The guard block holds nothing but the phis and the test, so a failed
+// guard leaves the header of the current iteration to the original loop.
+void LoopUnroller::PartiallyUnroll(const CountedLoop& info) {
+    BasicBlock* header = info.loop->header;
+    StartIterations(info);
+
+    BasicBlock* unrolled = graph_->CreateNewBasicBlock();
+    std::vector<PhiInst*> phis;
+    std::vector<Instruction*> inits;
+    for (auto* phi = header->GetFirstPhi(); phi; phi = phi->GetNext()) {
+        auto* copy = graph_->CreateInstruction<PhiInst>(phi->GetType(), unrolled);
+        unrolled->AppendInst(copy);
+        inits.push_back(Lookup(phi));
+        phis.push_back(copy);
+        cloner_.Map(phi, copy);
+    }
+
+    // enter the unrolled body only while factor more iterations will run
+    Type type = info.iv->phi->GetType();
+    auto ahead_by = static_cast<int64_t>(factor_ - 1);
+    auto* distance = graph_->CreateInstruction<ConstantInst>(type, info.preheader,
+        MakeConstantValue(type, *FoldBinaryOp(Opcode::Mul, type, ahead_by, info.iv->step)));
+    info.preheader->InsertBefore(info.preheader->GetLastInst(), distance);
+    auto* ahead = graph_->CreateInstruction<BinaryInst>(Opcode::Add, type, unrolled, Lookup(info.iv->phi), distance);
+    unrolled->AppendInst(ahead);
+    Instruction* lhs = info.iv_on_left ? ahead : Lookup(info.limit);
+    Instruction* rhs = info.iv_on_left ? Lookup(info.limit) : ahead;
+    auto* guard = graph_->CreateInstruction<BinaryInst>(Opcode::Cmp, info.cond->GetType(), unrolled, lhs, rhs);
+    unrolled->AppendInst(guard);
+
+    // like a copied latch, the first header copy jumps to the header
+    // without an edge until Retarget points it at its body
+    BasicBlock* first = graph_->CreateNewBasicBlock();
+    first->AppendInst(graph_->CreateInstruction<JumpInst>(first, header));
+    BasicBlock* tail = first;
+    for (size_t i = 0; i < factor_; ++i) {
+        CopyHeader(info, tail);
+        BasicBlock* latch = CopyBody(info, tail);
+        Retarget(info, tail, cloner_.GetClone(info.body_entry));
+        tail = latch;
+        AdvancePhis(info);
+    }
+    Retarget(info, tail, unrolled);
+
+    BasicBlock* on_true = info.continue_on_true ? first : header;
+    BasicBlock* on_false = info.continue_on_true ? header : first;
+    unrolled->AppendInst(graph_->CreateInstruction<IfInst>(unrolled, guard, on_true, on_false));
+    unrolled->LinkTo(on_true, on_false);
+    info.preheader->ReplaceSucc(header, unrolled);
+
+    // the original loop runs what is left, starting from the unrolled phis
+    size_t i = 0;
+    for (auto* phi_inst = header->GetFirstPhi(); phi_inst; phi_inst = phi_inst->GetNext(), ++i) {
+        auto* phi = cast<PhiInst>(phi_inst);
+        phis[i]->AddPhiInput(info.preheader, inits[i]);
+        phis[i]->AddPhiInput(tail, Lookup(phi));
+        for (size_t j = 0; j < phi->GetInputs().size(); ++j) {
+            if (phi->GetIncomingBlock(j) == info.preheader) phi->SetInput(j, phis[i]);
+        }
+        phi->ReplaceBlock(info.preheader, unrolled);
+    }
+}
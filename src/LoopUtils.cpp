@@ -0,0 +1,72 @@
+#include "LoopUtils.hpp"
+#include <algorithm>
+#include <utility>
+
+BasicBlock* LoopUtils::GetPreheader(const Loop* loop) {
+    BasicBlock* preheader = nullptr;
+    for (auto* pred : loop->header->GetPreds()) {
+        if (loop->Contains(pred)) continue;
+        if (preheader) return nullptr;
+        preheader = pred;
+    }
+    if (!preheader || preheader->GetSuccs().size() != 1) return nullptr;
+    if (!isa<JumpInst>(preheader->GetLastInst())) return nullptr;
+    return preheader;
+}
+
+BasicBlock* LoopUtils::EnsurePreheader(Graph* graph, Loop* loop) {
+    if (BasicBlock* existing = GetPreheader(loop)) return existing;
+
+    BasicBlock* header = loop->header;
+    std::vector<BasicBlock*> entering;
+    for (auto* pred : header->GetPreds()) {
+        if (!loop->Contains(pred)) entering.push_back(pred);
+    }
+
+    BasicBlock* preheader = graph->CreateNewBasicBlock();
+    for (auto* phi_inst = header->GetFirstPhi(); phi_inst; phi_inst = phi_inst->GetNext()) {
+        auto* phi = cast<PhiInst>(phi_inst);
+        std::vector<std::pair<BasicBlock*, Instruction*>> incoming;
+        for (size_t i = phi->GetInputs().size(); i-- > 0;) {
+            auto [from, input] = phi->GetPhiInputs()[i];
+            if (loop->Contains(from)) continue;
+            incoming.emplace_back(from, input);
+            phi->RemovePhiInput(i);
+        }
+        if (incoming.empty()) continue;
+
+        Instruction* value = incoming.front().second;
+        bool same = std::all_of(incoming.begin(), incoming.end(),
+            [value](const auto& in) { return in.second == value; });
+        if (!same) {
+            auto* merged = graph->CreateInstruction<PhiInst>(phi->GetType(), preheader);
+            for (auto it = incoming.rbegin(); it != incoming.rend(); ++it) {
+                merged->AddPhiInput(it->first, it->second);
+            }
+            preheader->AppendInst(merged);
+            value = merged;
+        }
+        phi->AddPhiInput(preheader, value);
+    }
+
+    for (auto* pred : entering) pred->ReplaceSucc(header, preheader);
+    preheader->AppendInst(graph->CreateInstruction<JumpInst>(preheader, header));
+    preheader->LinkTo(header);
+    return preheader;
+}
+
+std::vector<Loop*> LoopUtils::GetLoopsInnermostFirst(Loop* root) {
+    std::vector<Loop*> order;
+    std::vector<std::pair<Loop*, size_t>> stack;
+    stack.emplace_back(root, 0);
+    while (!stack.empty()) {
+        auto& [loop, next_sub] = stack.back();
+        if (next_sub < loop->sub_loops.size()) {
+            stack.emplace_back(loop->sub_loops[next_sub++], 0);
+        } else {
+            if (loop != root) order.push_back(loop);
+            stack.pop_back();
+        }
+    }
+    return order;
+}
@@ -1,136 +1,137 @@
 #include "Optimizer.hpp"
-#include <variant>
-
+#include "ConstantFolding.hpp"
+#include "PeepholeRules.hpp"
+#include "Statistics.hpp"
 
 void Optimizer::Run() {
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (auto& bb_ptr : graph_->GetBlocks()) {
-            Instruction* inst = bb_ptr->GetFirstInst();
-            while (inst) {
-                Instruction* next = inst->GetNext();
-                
-                bool optimized = false;
-                if (TryConstantFolding(inst)) {
-                    optimized = true;
-                } else if (TryPeephole(inst)) {
-                    optimized = true;
-                }
-
-                if (optimized) {
-                    changed = true;
-                    bb_ptr->RemoveInst(inst);
-                }
-                
-                inst = next;
-            }
+    PassStatsScope stats(graph_, "Optimizer");
+    queued_.Reset(graph_, false);
+    for (auto& bb_ptr : graph_->GetBlocks()) {
+        EnqueuePhis(bb_ptr.get());
+        for (auto* inst = bb_ptr->GetFirstInst(); inst; inst = inst->GetNext()) {
+            Enqueue(inst);
         }
     }
-}
 
-void Optimizer::ReplaceAllUses(Instruction* oldInst, Instruction* newInst) {
-    for (auto& bb_ptr : graph_->GetBlocks()) {
-        for (Instruction* inst = bb_ptr->GetFirstInst(); inst; inst = inst->GetNext()) {
-            inst->ReplaceInput(oldInst, newInst);
-        }
-        for (Instruction* inst = bb_ptr->GetFirstPhi(); inst; inst = inst->GetNext()) {
-            inst->ReplaceInput(oldInst, newInst);
+    // blocks are only dropped once the worklist is empty, so it never
+    // holds an instruction of a removed block
+    do {
+        while (!worklist_.empty()) {
+            Instruction* inst = worklist_.front();
+            worklist_.pop_front();
+            queued_[inst] = false;
+
+            if (Visit(inst)) {
+                changed_ = true;
+                inst->GetBasicBlock()->RemoveInst(inst);
+                inst->DropInputs();
+                graph_->FreeInstruction(inst);
+            }
         }
-    }
+    } while (RemoveUnreachableBlocks());
 }
 
-bool Optimizer::TryConstantFolding(Instruction* inst) {
-    auto* bin = dynamic_cast<BinaryInst*>(inst);
-    if (!bin) return false;
+bool Optimizer::RemoveUnreachableBlocks() {
+    if (!pending_unreachable_) return false;
+    pending_unreachable_ = false;
+    if (graph_->RemoveUnreachableBlocks() == 0) return false;
+    // removed predecessors took their phi inputs along
+    for (auto& bb_ptr : graph_->GetBlocks()) EnqueuePhis(bb_ptr.get());
+    return !worklist_.empty();
+}
 
-    auto* c1 = dynamic_cast<ConstantInst*>(bin->GetInputs()[0]);
-    auto* c2 = dynamic_cast<ConstantInst*>(bin->GetInputs()[1]);
+void Optimizer::Enqueue(Instruction* inst) {
+    if (queued_[inst]) return;
+    queued_[inst] = true;
+    worklist_.push_back(inst);
+}
 
-    if (c1 && c2) {
-        int64_t v1 = std::visit([](auto arg) { return static_cast<int64_t>(arg); }, c1->GetValue());
-        int64_t v2 = std::visit([](auto arg) { return static_cast<int64_t>(arg); }, c2->GetValue());
-        int64_t res = 0;
+void Optimizer::EnqueuePhis(BasicBlock* bb) {
+    for (auto* phi = bb->GetFirstPhi(); phi; phi = phi->GetNext()) Enqueue(phi);
+}
 
-        switch (bin->GetOpcode()) {
-            case Opcode::Mul: res = v1 * v2; break;
-            case Opcode::Or:  res = v1 | v2; break;
-            case Opcode::AShr: res = v1 >> v2; break;
-            default: return false;
-        }
+// inst itself is freed by Run() right after, so a phi that uses itself
+// must not be queued as its own user
+void Optimizer::ReplaceWith(Instruction* inst, Instruction* value) {
+    for (auto* user : inst->GetUsers()) {
+        if (user != inst) Enqueue(user);
+    }
+    inst->ReplaceAllUsesWith(value);
+}
+
+ConstantInst* Optimizer::NewConstant(Instruction* before, Type type, int64_t value) {
+    BasicBlock* bb = before->GetBasicBlock();
+    auto* constant = graph_->CreateInstruction<ConstantInst>(type, bb, MakeConstantValue(type, value));
+    bb->InsertBefore(before, constant);
+    Enqueue(constant);
+    return constant;
+}
 
-        IRBuilder builder(graph_);
-        builder.SetInsertPoint(inst->GetBasicBlock());
-        auto* newConst = builder.CreateConstant(inst->GetType(), res);
-        
-        ReplaceAllUses(inst, newConst);
+bool Optimizer::VisitBinary(BinaryInst* bin) {
+    if (TryConstantFolding(bin)) {
+        Statistics::Count(graph_, "Optimizer", "folded");
+        return true;
+    }
+    if (TryPeephole(bin)) {
+        Statistics::Count(graph_, "Optimizer", "peepholes");
         return true;
     }
     return false;
 }
 
-bool Optimizer::TryPeephole(Instruction* inst) {
-    auto* bin = dynamic_cast<BinaryInst*>(inst);
-    if (!bin) return false;
-
-    Instruction* lhs = bin->GetInputs()[0];
-    Instruction* rhs = bin->GetInputs()[1];
-    auto* const_rhs = dynamic_cast<ConstantInst*>(rhs);
-    auto* const_lhs = dynamic_cast<ConstantInst*>(lhs);
-
-    if (bin->GetOpcode() == Opcode::Mul && const_rhs) {
-        int64_t val = std::visit([](auto arg) { return static_cast<int64_t>(arg); }, const_rhs->GetValue());
-        
-        if (val == 1) {
-            ReplaceAllUses(inst, lhs);
-            return true;
-        }
-        if (val == 0) {
-            IRBuilder builder(graph_);
-            builder.SetInsertPoint(inst->GetBasicBlock());
-            auto* zero = builder.CreateConstant(inst->GetType(), 0);
-            ReplaceAllUses(inst, zero);
-            return true;
-        }
+bool Optimizer::VisitPhi(PhiInst* phi) {
+    Instruction* same = nullptr;
+    for (auto* input : phi->GetInputs()) {
+        if (input == phi || input == same) continue;
+        if (same) return false;
+        same = input;
     }
+    if (!same) return false;
+    ReplaceWith(phi, same);
+    Statistics::Count(graph_, "Optimizer", "phis_removed");
+    return true;
+}
 
-    if (bin->GetOpcode() == Opcode::Or) {
-        if (lhs == rhs) {
-            ReplaceAllUses(inst, lhs);
-            return true;
-        }
-        if (const_rhs) {
-            int64_t val = std::visit([](auto arg) { return static_cast<int64_t>(arg); }, const_rhs->GetValue());
-            if (val == 0) {
-                ReplaceAllUses(inst, lhs);
-                return true;
-            }
-            if (val == -1) {
-                ReplaceAllUses(inst, rhs);
-                return true;
-            }
-        }
-    }
+// If on a constant becomes a Jump to the taken successor; the other edge
+// goes away and blocks left without predecessors are removed later.
+bool Optimizer::VisitIf(IfInst* branch) {
+    auto* cond = dyn_cast<ConstantInst>(branch->GetInput(0));
+    if (!cond) return false;
 
-    if (bin->GetOpcode() == Opcode::AShr) {
-        // non commutative operation
-        // x >> 0 = x
-        // 0 >> x = 0
-        if (const_rhs) {
-            int64_t val = std::visit([](auto arg) { return static_cast<int64_t>(arg); }, const_rhs->GetValue());
-            if (val == 0) {
-                ReplaceAllUses(inst, lhs);
-                return true;
-            }
-        }
-        if (const_lhs) {
-            int64_t val = std::visit([](auto arg) { return static_cast<int64_t>(arg); }, const_lhs->GetValue());
-            if (val == 0) {
-                ReplaceAllUses(inst, lhs);
-                return true;
-            }
-        }
-    }
+    BasicBlock* bb = branch->GetBasicBlock();
+    bool taken = GetConstantValue(cond) != 0;
+    BasicBlock* target = taken ? branch->GetTrueTarget() : branch->GetFalseTarget();
+    BasicBlock* dropped = taken ? branch->GetFalseTarget() : branch->GetTrueTarget();
+
+    bb->InsertBefore(branch, graph_->CreateInstruction<JumpInst>(bb, target));
+    bb->RemoveEdgeTo(dropped);
+    EnqueuePhis(dropped);
+    pending_unreachable_ = true;
+    cfg_changed_ = true;
+    Statistics::Count(graph_, "Optimizer", "branches_folded");
+    return true;
+}
+
+bool Optimizer::TryConstantFolding(BinaryInst* bin) {
+    auto* c1 = dyn_cast<ConstantInst>(bin->GetInput(0));
+    auto* c2 = dyn_cast<ConstantInst>(bin->GetInput(1));
+    if (!c1 || !c2) return false;
+
+    auto res = FoldBinaryOp(bin->GetOpcode(), bin->GetType(), GetConstantValue(c1), GetConstantValue(c2));
+    if (!res) return false;
 
+    ReplaceWith(bin, NewConstant(bin, bin->GetType(), *res));
+    return true;
+}
+
+bool Optimizer::TryPeephole(BinaryInst* bin) {
+    for (PeepholeRule rule : PeepholeRules::For(bin->GetOpcode())) {
+        PeepholeBuilder builder(graph_, bin);
+        Instruction* replacement = rule(bin, builder);
+        if (!replacement) continue;
+        for (auto* inst : builder.GetCreated()) Enqueue(inst);
+        ReplaceWith(bin, replacement);
+        return true;
+    }
     return false;
-}
\ No newline at end of file
+}
@@ -0,0 +1,242 @@
+#include "PeepholeRules.hpp"
+#include "ConstantFolding.hpp"
+#include "PatternMatch.hpp"
+#include <array>
+
+using namespace PatternMatch;
+
+Instruction* PeepholeBuilder::Constant(int64_t value) {
+    Type type = root_->GetType();
+    BasicBlock* bb = root_->GetBasicBlock();
+    auto* constant = graph_->CreateInstruction<ConstantInst>(type, bb, MakeConstantValue(type, value));
+    bb->InsertBefore(root_, constant);
+    created_.push_back(constant);
+    return constant;
+}
+
+Instruction* PeepholeBuilder::Binary(Opcode opcode, Instruction* lhs, Instruction* rhs) {
+    BasicBlock* bb = root_->GetBasicBlock();
+    auto* inst = graph_->CreateInstruction<BinaryInst>(opcode, root_->GetType(), bb, lhs, rhs);
+    bb->InsertBefore(root_, inst);
+    created_.push_back(inst);
+    return inst;
+}
+
+namespace {
+
+int64_t TypeBits(Instruction* inst) {
+    return inst->GetType() == Type::int32 ? 32 : 64;
+}
+
+// x + 0 = x
+Instruction* AddZero(BinaryInst* inst, PeepholeBuilder&) {
+    Instruction* x = nullptr;
+    return Match(inst, m_c_Add(m_Value(x), m_Zero())) ? x : nullptr;
+}
+
+// (x - y) + y = x
+Instruction* AddOfSub(BinaryInst* inst, PeepholeBuilder&) {
+    Instruction* x = nullptr;
+    Instruction* y = nullptr;
+    return Match(inst, m_c_Add(m_Sub(m_Value(x), m_Value(y)), m_Deferred(y))) ? x : nullptr;
+}
+
+// x + (0 - y) = x - y
+Instruction* AddNegated(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    Instruction* y = nullptr;
+    if (!Match(inst, m_c_Add(m_Value(x), m_Neg(m_Value(y))))) return nullptr;
+    return builder.Binary(Opcode::Sub, x, y);
+}
+
+// (x + c1) + c2 = x + (c1 + c2)
+Instruction* AddConstants(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    int64_t c1 = 0;
+    int64_t c2 = 0;
+    if (!Match(inst, m_c_Add(m_c_Add(m_Value(x), m_AnyConstInt(c1)), m_AnyConstInt(c2)))) return nullptr;
+    int64_t sum = *FoldBinaryOp(Opcode::Add, inst->GetType(), c1, c2);
+    return builder.Binary(Opcode::Add, x, builder.Constant(sum));
+}
+
+// x + x = x << 1
+Instruction* AddSelf(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    if (!Match(inst, m_Add(m_Value(x), m_Deferred(x)))) return nullptr;
+    return builder.Binary(Opcode::Shl, x, builder.Constant(1));
+}
+
+// x - 0 = x
+Instruction* SubZero(BinaryInst* inst, PeepholeBuilder&) {
+    Instruction* x = nullptr;
+    return Match(inst, m_Sub(m_Value(x), m_Zero())) ? x : nullptr;
+}
+
+// x - x = 0
+Instruction* SubSelf(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    return Match(inst, m_Sub(m_Value(x), m_Deferred(x))) ? builder.Constant(0) : nullptr;
+}
+
+// 0 - (0 - x) = x
+Instruction* DoubleNegation(BinaryInst* inst, PeepholeBuilder&) {
+    Instruction* x = nullptr;
+    return Match(inst, m_Neg(m_Neg(m_Value(x)))) ? x : nullptr;
+}
+
+// (x + y) - y = x, (x + y) - x = y
+Instruction* SubOfAdd(BinaryInst* inst, PeepholeBuilder&) {
+    Instruction* x = nullptr;
+    Instruction* y = nullptr;
+    if (Match(inst, m_Sub(m_Add(m_Value(x), m_Value(y)), m_Deferred(y)))) return x;
+    if (Match(inst, m_Sub(m_Add(m_Value(x), m_Value(y)), m_Deferred(x)))) return y;
+    return nullptr;
+}
+
+// x - (0 - y) = x + y
+Instruction* SubNegated(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    Instruction* y = nullptr;
+    if (!Match(inst, m_Sub(m_Value(x), m_Neg(m_Value(y))))) return nullptr;
+    return builder.Binary(Opcode::Add, x, y);
+}
+
+// x - c = x + (-c), so that constant offsets only appear in Adds
+Instruction* SubConstant(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    int64_t c = 0;
+    if (!Match(inst, m_Sub(m_Value(x), m_AnyConstInt(c)))) return nullptr;
+    int64_t negated = *FoldBinaryOp(Opcode::Sub, inst->GetType(), 0, c);
+    return builder.Binary(Opcode::Add, x, builder.Constant(negated));
+}
+
+// x * 1 = x
+Instruction* MulOne(BinaryInst* inst, PeepholeBuilder&) {
+    Instruction* x = nullptr;
+    return Match(inst, m_c_Mul(m_Value(x), m_One())) ? x : nullptr;
+}
+
+// x * 0 = 0
+Instruction* MulZero(BinaryInst* inst, PeepholeBuilder& builder) {
+    return Match(inst, m_c_Mul(m_Value(), m_Zero())) ? builder.Constant(0) : nullptr;
+}
+
+// x * -1 = 0 - x
+Instruction* MulMinusOne(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    if (!Match(inst, m_c_Mul(m_Value(x), m_AllOnes()))) return nullptr;
+    return builder.Binary(Opcode::Sub, builder.Constant(0), x);
+}
+
+// x * 2^k = x << k
+Instruction* MulPowerOfTwo(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    int64_t log2 = 0;
+    if (!Match(inst, m_c_Mul(m_Value(x), m_PowerOfTwo(log2)))) return nullptr;
+    return builder.Binary(Opcode::Shl, x, builder.Constant(log2));
+}
+
+// (0 - x) * (0 - y) = x * y
+Instruction* MulNegated(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    Instruction* y = nullptr;
+    if (!Match(inst, m_Mul(m_Neg(m_Value(x)), m_Neg(m_Value(y))))) return nullptr;
+    return builder.Binary(Opcode::Mul, x, y);
+}
+
+// x | x = x
+Instruction* OrSelf(BinaryInst* inst, PeepholeBuilder&) {
+    Instruction* x = nullptr;
+    return Match(inst, m_Or(m_Value(x), m_Deferred(x))) ? x : nullptr;
+}
+
+// x | 0 = x
+Instruction* OrZero(BinaryInst* inst, PeepholeBuilder&) {
+    Instruction* x = nullptr;
+    return Match(inst, m_c_Or(m_Value(x), m_Zero())) ? x : nullptr;
+}
+
+// x | -1 = -1
+Instruction* OrAllOnes(BinaryInst* inst, PeepholeBuilder&) {
+    for (auto* operand : inst->GetInputs()) {
+        if (m_AllOnes().Match(operand)) return operand;
+    }
+    return nullptr;
+}
+
+// x >> 0 = x, x << 0 = x
+Instruction* ShiftByZero(BinaryInst* inst, PeepholeBuilder&) {
+    return m_Zero().Match(inst->GetInput(1)) ? inst->GetInput(0) : nullptr;
+}
+
+// 0 >> x = 0, 0 << x = 0, and -1 >> x = -1
+Instruction* ShiftOfConstant(BinaryInst* inst, PeepholeBuilder&) {
+    Instruction* value = inst->GetInput(0);
+    if (m_Zero().Match(value)) return value;
+    if (inst->GetOpcode() == Opcode::AShr && m_AllOnes().Match(value)) return value;
+    return nullptr;
+}
+
+// (x << a) << b = x << (a + b)
+Instruction* ShlOfShl(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    int64_t a = 0;
+    int64_t b = 0;
+    if (!Match(inst, m_Shl(m_Shl(m_Value(x), m_AnyConstInt(a)), m_AnyConstInt(b)))) return nullptr;
+    int64_t bits = TypeBits(inst);
+    if (a < 0 || b < 0 || a >= bits || b >= bits) return nullptr;
+    if (a + b >= bits) return builder.Constant(0);
+    return builder.Binary(Opcode::Shl, x, builder.Constant(a + b));
+}
+
+// x <= x
+Instruction* CmpSelf(BinaryInst* inst, PeepholeBuilder& builder) {
+    Instruction* x = nullptr;
+    return Match(inst, m_Cmp(m_Value(x), m_Deferred(x))) ? builder.Constant(1) : nullptr;
+}
+
+struct RuleEntry {
+    Opcode opcode;
+    PeepholeRule rule;
+};
+
+const RuleEntry kRules[] = {
+    {Opcode::Add, AddZero},
+    {Opcode::Add, AddOfSub},
+    {Opcode::Add, AddNegated},
+    {Opcode::Add, AddConstants},
+    {Opcode::Add, AddSelf},
+    {Opcode::Sub, SubZero},
+    {Opcode::Sub, SubSelf},
+    {Opcode::Sub, DoubleNegation},
+    {Opcode::Sub, SubOfAdd},
+    {Opcode::Sub, SubNegated},
+    {Opcode::Sub, SubConstant},
+    {Opcode::Mul, MulOne},
+    {Opcode::Mul, MulZero},
+    {Opcode::Mul, MulMinusOne},
+    {Opcode::Mul, MulPowerOfTwo},
+    {Opcode::Mul, MulNegated},
+    {Opcode::Or, OrSelf},
+    {Opcode::Or, OrZero},
+    {Opcode::Or, OrAllOnes},
+    {Opcode::AShr, ShiftByZero},
+    {Opcode::AShr, ShiftOfConstant},
+    {Opcode::Shl, ShiftByZero},
+    {Opcode::Shl, ShiftOfConstant},
+    {Opcode::Shl, ShlOfShl},
+    {Opcode::Cmp, CmpSelf},
+};
+
+constexpr size_t kOpcodeCount = static_cast<size_t>(Opcode::StoreArray) + 1;
+
+} // namespace
+
+const std::vector<PeepholeRule>& PeepholeRules::For(Opcode opcode) {
+    static const auto table = [] {
+        std::array<std::vector<PeepholeRule>, kOpcodeCount> buckets;
+        for (const auto& entry : kRules) buckets[static_cast<size_t>(entry.opcode)].push_back(entry.rule);
+        return buckets;
+    }();
+    return table[static_cast<size_t>(opcode)];
+}
@@ -0,0 +1,142 @@
+#include "RangeAnalysis.hpp"
+#include "ConstantFolding.hpp"
+#include "Statistics.hpp"
+
+static ValueRange FitToType(Type type, int64_t min, int64_t max, bool overflow) {
+    ValueRange full = ValueRange::Full(type);
+    if (overflow || min < full.min || max > full.max) return full;
+    return {min, max};
+}
+
+void RangeAnalysis::Run() {
+    PassStatsScope stats(graph_, "RangeAnalysis");
+    ivs_.Run();
+    ranges_.Reset(graph_);
+    computed_.Reset(graph_, false);
+
+    for (auto* bb : graph_->GetRPO()) {
+        for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) {
+            const InductionVariable* iv = ivs_.Get(inst);
+            ranges_[inst] = iv && iv->basic->phi == inst ? ComputeInductionVariable(iv->basic) : Compute(inst);
+            computed_[inst] = true;
+        }
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            ranges_[inst] = Compute(inst);
+            computed_[inst] = true;
+        }
+    }
+}
+
+ValueRange RangeAnalysis::GetRange(const Instruction* inst) const {
+    return computed_.Get(inst) ? ranges_.Get(inst) : ValueRange::Full(inst->GetType());
+}
+
+ValueRange RangeAnalysis::Compute(Instruction* inst) const {
+    Type type = inst->GetType();
+    switch (inst->GetOpcode()) {
+        case Opcode::Const:
+            return ValueRange::Constant(GetConstantValue(cast<ConstantInst>(inst)));
+        case Opcode::Cmp:
+            return {0, 1};
+        case Opcode::Add: {
+            ValueRange lhs = GetRange(inst->GetInput(0));
+            ValueRange rhs = GetRange(inst->GetInput(1));
+            int64_t min = 0;
+            int64_t max = 0;
+            bool overflow = __builtin_add_overflow(lhs.min, rhs.min, &min);
+            overflow |= __builtin_add_overflow(lhs.max, rhs.max, &max);
+            return FitToType(type, min, max, overflow);
+        }
+        case Opcode::Sub: {
+            ValueRange lhs = GetRange(inst->GetInput(0));
+            ValueRange rhs = GetRange(inst->GetInput(1));
+            int64_t min = 0;
+            int64_t max = 0;
+            bool overflow = __builtin_sub_overflow(lhs.min, rhs.max, &min);
+            overflow |= __builtin_sub_overflow(lhs.max, rhs.min, &max);
+            return FitToType(type, min, max, overflow);
+        }
+        case Opcode::Mul: {
+            ValueRange lhs = GetRange(inst->GetInput(0));
+            ValueRange rhs = GetRange(inst->GetInput(1));
+            int64_t corners[4];
+            bool overflow = __builtin_mul_overflow(lhs.min, rhs.min, &corners[0]);
+            overflow |= __builtin_mul_overflow(lhs.min, rhs.max, &corners[1]);
+            overflow |= __builtin_mul_overflow(lhs.max, rhs.min, &corners[2]);
+            overflow |= __builtin_mul_overflow(lhs.max, rhs.max, &corners[3]);
+            auto [min, max] = std::minmax({corners[0], corners[1], corners[2], corners[3]});
+            return FitToType(type, min, max, overflow);
+        }
+        case Opcode::AShr: {
+            ValueRange lhs = GetRange(inst->GetInput(0));
+            ValueRange shift = GetRange(inst->GetInput(1));
+            if (!shift.IsConstant()) return ValueRange::Full(type);
+            int64_t amount = shift.min & (type == Type::int32 ? 31 : 63);
+            return {lhs.min >> amount, lhs.max >> amount};
+        }
+        case Opcode::Phi: {
+            ValueRange range = GetRange(inst->GetInput(0));
+            for (auto* input : inst->GetInputs()) range = range.Union(GetRange(input));
+            return range;
+        }
+        case Opcode::BoundsCheck: {
+            // execution only continues past a check that passed
+            ValueRange index = GetRange(inst->GetInput(0));
+            ValueRange length = GetRange(inst->GetInput(1));
+            return {std::max<int64_t>(index.min, 0), std::min(index.max, length.max - 1)};
+        }
+        default:
+            return ValueRange::Full(type);
+    }
+}
+
+ValueRange RangeAnalysis::ComputeInductionVariable(const BasicInductionVariable* iv) {
+    Type type = iv->phi->GetType();
+    ValueRange full = ValueRange::Full(type);
+    auto* init = dyn_cast<ConstantInst>(iv->init);
+    if (!init || iv->step == 0) return full;
+
+    // assume the variable only moves away from init, then check that the
+    // branches in front of the update keep it from wrapping
+    int64_t start = GetConstantValue(init);
+    ValueRange assumed = iv->step > 0 ? ValueRange{start, full.max} : ValueRange{full.min, start};
+    ranges_[iv->phi] = assumed;
+    computed_[iv->phi] = true;
+    ValueRange at_update = RangeAt(iv->phi, iv->update->GetBasicBlock(), 0);
+    bool wraps = iv->step > 0 ? at_update.max > full.max - iv->step : at_update.min < full.min - iv->step;
+    return wraps ? full : assumed;
+}
+
+ValueRange RangeAnalysis::RangeAt(Instruction* value, BasicBlock* bb, int depth) const {
+    ValueRange range = GetRange(value);
+    if (depth > kMaxDepth) return range;
+    Type type = value->GetType();
+    ValueRange full = ValueRange::Full(type);
+
+    ForEachFact(bb, [&](BinaryInst* cmp, bool holds) {
+        Instruction* lhs = cmp->GetInput(0);
+        Instruction* rhs = cmp->GetInput(1);
+        if (lhs == rhs || (lhs != value && rhs != value)) return;
+        bool is_lhs = lhs == value;
+        ValueRange other = RangeAt(is_lhs ? rhs : lhs, bb, depth + 1);
+        // holds: lhs <= rhs, otherwise lhs > rhs
+        if (holds == is_lhs) {
+            int64_t bound = holds ? other.max : (other.max == full.min ? full.min : other.max - 1);
+            range.max = std::min(range.max, bound);
+        } else {
+            int64_t bound = holds ? other.min : (other.min == full.max ? full.max : other.min + 1);
+            range.min = std::max(range.min, bound);
+        }
+    });
+    return range;
+}
+
+bool RangeAnalysis::ProvesLess(Instruction* lhs, Instruction* rhs, BasicBlock* bb) const {
+    if (RangeAt(lhs, bb, 0).max < RangeAt(rhs, bb, 0).min) return true;
+    bool proven = false;
+    ForEachFact(bb, [&](BinaryInst* cmp, bool holds) {
+        // !(rhs <= lhs) is lhs < rhs
+        proven |= !holds && cmp->GetInput(0) == rhs && cmp->GetInput(1) == lhs;
+    });
+    return proven;
+}
@@ -0,0 +1,171 @@
+#include "Reassociate.hpp"
+#include "ConstantFolding.hpp"
+#include "Statistics.hpp"
+#include <algorithm>
+
+static bool IsReassociable(Opcode opcode) {
+    return opcode == Opcode::Add || opcode == Opcode::Mul || opcode == Opcode::Or;
+}
+
+static int64_t GetIdentity(Opcode opcode) {
+    return opcode == Opcode::Mul ? 1 : 0;
+}
+
+// x * 0 and x | -1 do not depend on x
+static bool IsAbsorbing(Opcode opcode, int64_t value) {
+    return (opcode == Opcode::Mul && value == 0) || (opcode == Opcode::Or && value == -1);
+}
+
+void Reassociate::Run() {
+    PassStatsScope stats(graph_, "Reassociate");
+    size_t rewritten_before = rewritten_count_;
+    size_t removed_before = removed_count_;
+    ComputeRanks();
+
+    std::vector<BinaryInst*> roots;
+    for (auto* bb : graph_->GetRPO()) {
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            auto* bin = dyn_cast<BinaryInst>(inst);
+            if (bin && IsReassociable(bin->GetOpcode()) && IsTreeRoot(bin)) roots.push_back(bin);
+        }
+    }
+    // roots are never inner nodes of another tree, so rewriting one tree
+    // leaves the other roots in place
+    for (auto* root : roots) {
+        Tree tree;
+        tree.root = root;
+        Collect(root, tree);
+        if (Rewrite(tree)) rewritten_count_++;
+    }
+    Statistics::Count(graph_, "Reassociate", "rewritten", static_cast<int64_t>(rewritten_count_ - rewritten_before));
+    Statistics::Count(graph_, "Reassociate", "removed", static_cast<int64_t>(removed_count_ - removed_before));
+}
+
+// Non-phi operands dominate their user, so one pass in RPO sees them
+// before the expressions using them.
+void Reassociate::ComputeRanks() {
+    ranks_.Reset(graph_, 0);
+    int64_t block_rank = 0;
+    for (auto* bb : graph_->GetRPO()) {
+        block_rank++;
+        for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) ranks_[inst] = block_rank;
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (isa<ConstantInst>(inst)) {
+                ranks_[inst] = 0;
+            } else if (isa<BinaryInst>(inst)) {
+                ranks_[inst] = std::max(ranks_.Get(inst->GetInput(0)), ranks_.Get(inst->GetInput(1)));
+            } else {
+                ranks_[inst] = block_rank;
+            }
+        }
+    }
+}
+
+bool Reassociate::IsInnerNode(Instruction* inst, const BinaryInst* root) const {
+    if (inst->GetOpcode() != root->GetOpcode() || inst->GetType() != root->GetType()) return false;
+    if (inst->GetBasicBlock() != root->GetBasicBlock()) return false;
+    Use* use = inst->GetFirstUse();
+    return use && !use->GetNext();
+}
+
+bool Reassociate::IsTreeRoot(BinaryInst* inst) const {
+    Use* use = inst->GetFirstUse();
+    if (!use || use->GetNext()) return true;
+    auto* user = dyn_cast<BinaryInst>(use->GetUser());
+    return !user || !IsInnerNode(inst, user);
+}
+
+void Reassociate::Collect(Instruction* inst, Tree& tree) const {
+    std::vector<Instruction*> stack = {inst};
+    while (!stack.empty()) {
+        Instruction* node = stack.back();
+        stack.pop_back();
+        tree.nodes.push_back(node);
+        // right operand first, so leaves come out left to right
+        for (size_t i = 2; i-- > 0;) {
+            Instruction* operand = node->GetInput(i);
+            if (IsInnerNode(operand, tree.root)) {
+                stack.push_back(operand);
+            } else {
+                tree.leaves.push_back(operand);
+            }
+        }
+    }
+    std::reverse(tree.leaves.begin(), tree.leaves.end());
+}
+
+bool Reassociate::Rewrite(Tree& tree) {
+    BinaryInst* root = tree.root;
+    Opcode opcode = root->GetOpcode();
+    Type type = root->GetType();
+    BasicBlock* bb = root->GetBasicBlock();
+
+    int64_t folded = GetIdentity(opcode);
+    ConstantInst* single_constant = nullptr;
+    size_t constant_count = 0;
+    std::vector<Instruction*> operands;
+    for (auto* leaf : tree.leaves) {
+        if (auto* constant = dyn_cast<ConstantInst>(leaf)) {
+            folded = *FoldBinaryOp(opcode, type, folded, GetConstantValue(constant));
+            single_constant = constant;
+            constant_count++;
+        } else {
+            operands.push_back(leaf);
+        }
+    }
+    std::stable_sort(operands.begin(), operands.end(), [this](Instruction* lhs, Instruction* rhs) {
+        int64_t lhs_rank = ranks_.Get(lhs);
+        int64_t rhs_rank = ranks_.Get(rhs);
+        return lhs_rank != rhs_rank ? lhs_rank < rhs_rank : lhs->GetId() < rhs->GetId();
+    });
+    if (opcode == Opcode::Or) {
+        // x | x = x
+        operands.erase(std::unique(operands.begin(), operands.end()), operands.end());
+    }
+
+    auto new_constant = [&](int64_t value) -> Instruction* {
+        auto* constant = graph_->CreateInstruction<ConstantInst>(type, bb, MakeConstantValue(type, value));
+        bb->InsertBefore(root, constant);
+        return constant;
+    };
+
+    std::vector<Instruction*> chain = operands;
+    Instruction* replacement = nullptr;
+    if (IsAbsorbing(opcode, folded) && constant_count > 0) {
+        chain.clear();
+        replacement = constant_count == 1 ? single_constant : new_constant(folded);
+    } else if (folded != GetIdentity(opcode) || chain.empty()) {
+        chain.push_back(constant_count == 1 ? single_constant : nullptr);
+    }
+
+    if (!replacement) {
+        // keep trees that already have the canonical shape
+        bool canonical = constant_count <= 1 && chain.size() == tree.leaves.size();
+        Instruction* node = root;
+        for (size_t i = chain.size(); canonical && i-- > 1;) {
+            canonical = chain[i] && node->GetInput(1) == chain[i];
+            node = node->GetInput(0);
+            if (i > 1 && canonical) canonical = IsInnerNode(node, root);
+        }
+        if (canonical && node == chain[0]) return false;
+
+        if (!chain.back()) chain.back() = new_constant(folded);
+        replacement = chain[0];
+        for (size_t i = 1; i < chain.size(); ++i) {
+            auto* inst = graph_->CreateInstruction<BinaryInst>(opcode, type, bb, replacement, chain[i]);
+            bb->InsertBefore(root, inst);
+            ranks_[inst] = std::max(ranks_.Get(replacement), ranks_.Get(chain[i]));
+            replacement = inst;
+        }
+    }
+
+    root->ReplaceAllUsesWith(replacement);
+    for (auto* node : tree.nodes) {
+        bb->RemoveInst(node);
+        node->DropInputs();
+    }
+    for (auto* node : tree.nodes) graph_->FreeInstruction(node);
+    size_t built = chain.empty() ? 0 : chain.size() - 1;
+    if (tree.nodes.size() > built) removed_count_ += tree.nodes.size() - built;
+    return true;
+}
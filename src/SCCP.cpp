@@ -0,0 +1,151 @@
+#include "SCCP.hpp"
+#include "ConstantFolding.hpp"
+#include "Statistics.hpp"
+
+using LatticeValue = SCCP::LatticeValue;
+
+static LatticeValue Overdefined() { return {LatticeValue::Kind::Overdefined, 0}; }
+static LatticeValue Constant(int64_t value) { return {LatticeValue::Kind::Constant, value}; }
+
+void SCCP::Run() {
+    PassStatsScope stats(graph_, "SCCP");
+    values_.Reset(graph_);
+    executable_.Reset(graph_, false);
+    executable_edges_.clear();
+    constants_ = 0;
+    folded_branches_ = 0;
+    if (!graph_->GetEntryBlock()) return;
+
+    Solve();
+    Rewrite();
+}
+
+void SCCP::Solve() {
+    cfg_worklist_.push_back(graph_->GetEntryBlock());
+
+    while (!cfg_worklist_.empty() || !ssa_worklist_.empty()) {
+        while (!cfg_worklist_.empty()) {
+            BasicBlock* to = cfg_worklist_.back();
+            cfg_worklist_.pop_back();
+            bool first_visit = !executable_[to];
+            executable_[to] = true;
+
+            for (auto* phi = to->GetFirstPhi(); phi; phi = phi->GetNext()) VisitInst(phi);
+            if (first_visit) {
+                for (auto* inst = to->GetFirstInst(); inst; inst = inst->GetNext()) VisitInst(inst);
+            }
+        }
+        while (!ssa_worklist_.empty()) {
+            Instruction* inst = ssa_worklist_.back();
+            ssa_worklist_.pop_back();
+            if (executable_[inst->GetBasicBlock()]) VisitInst(inst);
+        }
+    }
+}
+
+void SCCP::MarkEdge(BasicBlock* from, BasicBlock* to) {
+    if (!executable_edges_.insert({from->GetId(), to->GetId()}).second) return;
+    cfg_worklist_.push_back(to);
+}
+
+void SCCP::VisitInst(Instruction* inst) {
+    if (auto* jump = dyn_cast<JumpInst>(inst)) {
+        MarkEdge(inst->GetBasicBlock(), jump->GetTarget());
+        return;
+    }
+    if (auto* branch = dyn_cast<IfInst>(inst)) {
+        LatticeValue cond = values_[branch->GetInput(0)];
+        if (cond.kind == LatticeValue::Kind::Unknown) return;
+        if (cond.kind == LatticeValue::Kind::Overdefined || cond.value != 0) {
+            MarkEdge(inst->GetBasicBlock(), branch->GetTrueTarget());
+        }
+        if (cond.kind == LatticeValue::Kind::Overdefined || cond.value == 0) {
+            MarkEdge(inst->GetBasicBlock(), branch->GetFalseTarget());
+        }
+        return;
+    }
+
+    LatticeValue value = Evaluate(inst);
+    if (value == values_[inst]) return;
+    values_[inst] = value;
+    for (auto* user : inst->GetUsers()) ssa_worklist_.push_back(user);
+}
+
+LatticeValue SCCP::Evaluate(Instruction* inst) const {
+    switch (inst->GetOpcode()) {
+        case Opcode::Const:
+            return Constant(GetConstantValue(static_cast<ConstantInst*>(inst)));
+        case Opcode::Phi:
+            return EvaluatePhi(static_cast<PhiInst*>(inst));
+        default:
+            break;
+    }
+    if (!isa<BinaryInst>(inst)) return Overdefined();
+
+    LatticeValue lhs = values_.Get(inst->GetInput(0));
+    LatticeValue rhs = values_.Get(inst->GetInput(1));
+    if (lhs.kind == LatticeValue::Kind::Overdefined || rhs.kind == LatticeValue::Kind::Overdefined) {
+        return Overdefined();
+    }
+    if (!lhs.IsConstant() || !rhs.IsConstant()) return {};
+    auto folded = FoldBinaryOp(inst->GetOpcode(), inst->GetType(), lhs.value, rhs.value);
+    return folded ? Constant(*folded) : Overdefined();
+}
+
+LatticeValue SCCP::EvaluatePhi(PhiInst* phi) const {
+    LatticeValue result;
+    for (const auto& [block, input] : phi->GetPhiInputs()) {
+        if (!IsEdgeExecutable(block, phi->GetBasicBlock())) continue;
+        LatticeValue value = values_.Get(input);
+        if (value.kind == LatticeValue::Kind::Unknown) continue;
+        if (value.kind == LatticeValue::Kind::Overdefined) return Overdefined();
+        if (result.IsConstant() && result.value != value.value) return Overdefined();
+        result = value;
+    }
+    return result;
+}
+
+void SCCP::Rewrite() {
+    std::vector<Instruction*> dead;
+    for (auto& bb_ptr : graph_->GetBlocks()) {
+        BasicBlock* bb = bb_ptr.get();
+        if (!executable_[bb]) continue;
+
+        auto materialize = [&](Instruction* inst, Instruction* before) {
+            LatticeValue value = values_[inst];
+            if (!value.IsConstant() || isa<ConstantInst>(inst) || !before) return;
+            auto* constant = graph_->CreateInstruction<ConstantInst>(inst->GetType(), bb,
+                MakeConstantValue(inst->GetType(), value.value));
+            bb->InsertBefore(before, constant);
+            inst->ReplaceAllUsesWith(constant);
+            dead.push_back(inst);
+            constants_++;
+        };
+        for (auto* phi = bb->GetFirstPhi(); phi; phi = phi->GetNext()) materialize(phi, bb->GetFirstInst());
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) materialize(inst, inst);
+
+        auto* branch = dyn_cast<IfInst>(bb->GetLastInst());
+        if (!branch) continue;
+        bool true_taken = IsEdgeExecutable(bb, branch->GetTrueTarget());
+        bool false_taken = IsEdgeExecutable(bb, branch->GetFalseTarget());
+        if (true_taken == false_taken) continue;
+
+        BasicBlock* target = true_taken ? branch->GetTrueTarget() : branch->GetFalseTarget();
+        BasicBlock* dropped = true_taken ? branch->GetFalseTarget() : branch->GetTrueTarget();
+        bb->InsertBefore(branch, graph_->CreateInstruction<JumpInst>(bb, target));
+        bb->RemoveEdgeTo(dropped);
+        dead.push_back(branch);
+        folded_branches_++;
+    }
+
+    for (auto* inst : dead) {
+        inst->GetBasicBlock()->RemoveInst(inst);
+        inst->DropInputs();
+        graph_->FreeInstruction(inst);
+    }
+    size_t removed_blocks = folded_branches_ ? graph_->RemoveUnreachableBlocks() : 0;
+
+    Statistics::Count(graph_, "SCCP", "constants", static_cast<int64_t>(constants_));
+    Statistics::Count(graph_, "SCCP", "branches_folded", static_cast<int64_t>(folded_branches_));
+    Statistics::Count(graph_, "SCCP", "removed_blocks", static_cast<int64_t>(removed_blocks));
+}
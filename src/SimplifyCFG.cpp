@@ -0,0 +1,156 @@
+#include "SimplifyCFG.hpp"
+#include "ConstantFolding.hpp"
+#include "Statistics.hpp"
+#include <algorithm>
+#include <vector>
+
+static Instruction* GetIncomingValue(PhiInst* phi, BasicBlock* bb) {
+    for (auto [from, value] : phi->GetPhiInputs()) {
+        if (from == bb) return value;
+    }
+    return nullptr;
+}
+
+static bool HasPred(BasicBlock* bb, BasicBlock* pred) {
+    const auto& preds = bb->GetPreds();
+    return std::find(preds.begin(), preds.end(), pred) != preds.end();
+}
+
+static bool HasDuplicatePreds(BasicBlock* bb) {
+    std::vector<BasicBlock*> preds(bb->GetPreds().begin(), bb->GetPreds().end());
+    std::sort(preds.begin(), preds.end());
+    return std::adjacent_find(preds.begin(), preds.end()) != preds.end();
+}
+
+void SimplifyCFG::Run() {
+    PassStatsScope stats(graph_, "SimplifyCFG");
+    size_t merged_before = merged_count_;
+    size_t removed_before = removed_count_;
+    size_t threaded_before = threaded_count_;
+    changed_ = graph_->RemoveUnreachableBlocks() > 0;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        removed_.clear();
+        is_removed_.Reset(graph_, false);
+        std::vector<BasicBlock*> rpo = graph_->GetRPO();
+        rpo_index_.Reset(graph_);
+        for (size_t i = 0; i < rpo.size(); ++i) rpo_index_[rpo[i]] = i;
+        for (auto* bb : rpo) {
+            if (is_removed_[bb]) continue;
+            while (MergeIntoPredecessor(bb)) changed = true;
+            if (RemoveEmptyBlock(bb) || ThreadJumps(bb)) changed = true;
+        }
+        graph_->RemoveBlocks(removed_);
+        // threading can leave blocks without predecessors
+        if (graph_->RemoveUnreachableBlocks() > 0) changed = true;
+        changed_ |= changed;
+    }
+    Statistics::Count(graph_, "SimplifyCFG", "merged", static_cast<int64_t>(merged_count_ - merged_before));
+    Statistics::Count(graph_, "SimplifyCFG", "removed_empty", static_cast<int64_t>(removed_count_ - removed_before));
+    Statistics::Count(graph_, "SimplifyCFG", "threaded", static_cast<int64_t>(threaded_count_ - threaded_before));
+}
+
+void SimplifyCFG::Remove(BasicBlock* bb) {
+    removed_.push_back(bb);
+    is_removed_[bb] = true;
+}
+
+// Appends the only successor of bb to it.
+bool SimplifyCFG::MergeIntoPredecessor(BasicBlock* bb) {
+    auto* jump = dyn_cast<JumpInst>(bb->GetLastInst());
+    if (!jump || bb->GetSuccs().size() != 1) return false;
+    BasicBlock* succ = jump->GetTarget();
+    if (succ == bb || succ == graph_->GetEntryBlock() || succ->GetPreds().size() != 1) return false;
+
+    // phis with a single predecessor are copies
+    while (auto* phi = succ->GetFirstPhi()) {
+        Instruction* value = phi->GetInput(0);
+        phi->ReplaceAllUsesWith(value);
+        succ->RemoveInst(phi);
+        phi->DropInputs();
+        graph_->FreeInstruction(phi);
+    }
+    bb->RemoveEdgeTo(succ);
+    bb->RemoveInst(jump);
+    jump->DropInputs();
+    graph_->FreeInstruction(jump);
+    while (auto* inst = succ->GetFirstInst()) {
+        succ->RemoveInst(inst);
+        bb->AppendInst(inst);
+    }
+
+    std::vector<BasicBlock*> next(succ->GetSuccs().begin(), succ->GetSuccs().end());
+    for (auto* target : next) {
+        bb->LinkTo(target);
+        for (auto* phi = target->GetFirstPhi(); phi; phi = phi->GetNext()) {
+            cast<PhiInst>(phi)->ReplaceBlock(succ, bb);
+        }
+        // no inputs of succ are left for RemoveEdgeTo to drop
+        succ->RemoveEdgeTo(target);
+    }
+    Remove(succ);
+    merged_count_++;
+    return true;
+}
+
+bool SimplifyCFG::RemoveEmptyBlock(BasicBlock* bb) {
+    auto* jump = dyn_cast<JumpInst>(bb->GetFirstInst());
+    if (!jump || bb->GetFirstPhi() || bb == graph_->GetEntryBlock()) return false;
+    BasicBlock* target = jump->GetTarget();
+    if (target == bb || bb->GetPreds().empty()) return false;
+
+    // a predecessor reaching target both directly and through bb may need
+    // two different phi inputs for the same edge
+    if (target->GetFirstPhi()) {
+        if (HasDuplicatePreds(bb)) return false;
+        for (auto* pred : bb->GetPreds()) {
+            if (HasPred(target, pred)) return false;
+        }
+    }
+
+    std::vector<BasicBlock*> preds(bb->GetPreds().begin(), bb->GetPreds().end());
+    for (auto* phi = target->GetFirstPhi(); phi; phi = phi->GetNext()) {
+        auto* target_phi = cast<PhiInst>(phi);
+        Instruction* value = GetIncomingValue(target_phi, bb);
+        for (auto* pred : preds) target_phi->AddPhiInput(pred, value);
+    }
+    for (auto* pred : preds) pred->ReplaceSucc(bb, target);
+    bb->RemoveEdgeTo(target);
+    Remove(bb);
+    removed_count_++;
+    return true;
+}
+
+bool SimplifyCFG::ThreadJumps(BasicBlock* bb) {
+    auto* branch = dyn_cast<IfInst>(bb->GetFirstInst());
+    auto* cond = branch ? dyn_cast<PhiInst>(branch->GetInput(0)) : nullptr;
+    if (!cond || cond->GetBasicBlock() != bb || cond->GetNext() || bb->GetFirstPhi() != cond) return false;
+    Use* use = cond->GetFirstUse();
+    if (!use || use->GetNext()) return false;
+    if (HasDuplicatePreds(bb)) return false;
+    for (auto* pred : bb->GetPreds()) {
+        if (rpo_index_[pred] >= rpo_index_[bb]) return false;
+    }
+
+    bool threaded = false;
+    std::vector<BasicBlock*> preds(bb->GetPreds().begin(), bb->GetPreds().end());
+    for (auto* pred : preds) {
+        auto* value = dyn_cast<ConstantInst>(GetIncomingValue(cond, pred));
+        if (!value || pred == bb) continue;
+        BasicBlock* target = GetConstantValue(value) != 0 ? branch->GetTrueTarget() : branch->GetFalseTarget();
+        if (target == bb || HasPred(target, pred)) continue;
+
+        // values bb passes on are defined above it, so they reach pred too
+        for (auto* phi = target->GetFirstPhi(); phi; phi = phi->GetNext()) {
+            auto* target_phi = cast<PhiInst>(phi);
+            target_phi->AddPhiInput(pred, GetIncomingValue(target_phi, bb));
+        }
+        pred->ReplaceSucc(bb, target);
+        cond->RemoveIncomingBlock(pred);
+        threaded_count_++;
+        threaded = true;
+    }
+    return threaded;
+}
@@ -0,0 +1,139 @@
+#include "Statistics.hpp"
+#include "Graph.hpp"
+#include <sstream>
+
+static int64_t CountInstructions(const Graph* graph) {
+    int64_t count = 0;
+    for (const auto& bb : graph->GetBlocks()) {
+        for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) count++;
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) count++;
+    }
+    return count;
+}
+
+static void WriteString(std::ostream& os, std::string_view str) {
+    os << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') os << '\\';
+        os << c;
+    }
+    os << '"';
+}
+
+static void WritePasses(std::ostream& os, const std::map<std::string, Statistics::PassRecord, std::less<>>& passes) {
+    os << '{';
+    bool first_pass = true;
+    for (const auto& [name, record] : passes) {
+        if (!first_pass) os << ',';
+        first_pass = false;
+        WriteString(os, name);
+        os << ":{\"runs\":" << record.runs << ",\"time_ms\":" << record.time_ms;
+        for (const auto& [counter, value] : record.counters) {
+            os << ',';
+            WriteString(os, counter);
+            os << ':' << value;
+        }
+        os << '}';
+    }
+    os << '}';
+}
+
+Statistics& Statistics::Get() {
+    static Statistics instance;
+    return instance;
+}
+
+Statistics::GraphRecord& Statistics::FindOrAdd(const Graph* graph) {
+    auto [it, inserted] = graph_index_.try_emplace(graph->GetUid(), graphs_.size());
+    if (inserted) graphs_.push_back({"graph" + std::to_string(it->second), {}});
+    return graphs_[it->second];
+}
+
+const Statistics::GraphRecord* Statistics::FindGraph(const Graph* graph) const {
+    auto it = graph_index_.find(graph->GetUid());
+    return it != graph_index_.end() ? &graphs_[it->second] : nullptr;
+}
+
+void Statistics::SetGraphName(const Graph* graph, std::string name) {
+    FindOrAdd(graph).name = std::move(name);
+}
+
+Statistics::PassRecord& Statistics::Record(const Graph* graph, std::string_view pass) {
+    auto& passes = FindOrAdd(graph).passes;
+    auto it = passes.find(pass);
+    if (it == passes.end()) it = passes.emplace(std::string(pass), PassRecord{}).first;
+    return it->second;
+}
+
+const Statistics::PassRecord* Statistics::Find(const Graph* graph, std::string_view pass) const {
+    const auto* record = FindGraph(graph);
+    if (!record) return nullptr;
+    auto it = record->passes.find(pass);
+    return it != record->passes.end() ? &it->second : nullptr;
+}
+
+void Statistics::AddCounter(const Graph* graph, std::string_view pass, std::string_view counter, int64_t delta) {
+    auto& counters = Record(graph, pass).counters;
+    auto it = counters.find(counter);
+    if (it == counters.end()) it = counters.emplace(std::string(counter), 0).first;
+    it->second += delta;
+}
+
+static void WriteGraph(std::ostream& os, std::string_view name,
+                       const std::map<std::string, Statistics::PassRecord, std::less<>>& passes) {
+    os << "{\"graph\":";
+    WriteString(os, name);
+    os << ",\"passes\":";
+    WritePasses(os, passes);
+    os << '}';
+}
+
+std::string Statistics::ToJson(const Graph* graph) const {
+    std::ostringstream os;
+    const auto* record = FindGraph(graph);
+    static const std::map<std::string, Statistics::PassRecord, std::less<>> kNoPasses;
+    WriteGraph(os, record ? record->name : std::string_view(), record ? record->passes : kNoPasses);
+    return os.str();
+}
+
+std::string Statistics::ToJson() const {
+    std::map<std::string, PassRecord, std::less<>> total;
+    std::ostringstream os;
+    os << "{\"graphs\":[";
+    for (size_t i = 0; i < graphs_.size(); ++i) {
+        if (i) os << ',';
+        WriteGraph(os, graphs_[i].name, graphs_[i].passes);
+        for (const auto& [name, record] : graphs_[i].passes) {
+            auto& sum = total[name];
+            sum.runs += record.runs;
+            sum.time_ms += record.time_ms;
+            for (const auto& [counter, value] : record.counters) sum.counters[counter] += value;
+        }
+    }
+    os << "],\"total\":";
+    WritePasses(os, total);
+    os << '}';
+    return os.str();
+}
+
+PassStatsScope::PassStatsScope(const Graph* graph, std::string_view pass) {
+    if (!Statistics::IsEnabled()) return;
+    graph_ = graph;
+    pass_ = pass;
+    insts_before_ = CountInstructions(graph);
+    blocks_before_ = static_cast<int64_t>(graph->GetBlocks().size());
+    start_ = std::chrono::steady_clock::now();
+}
+
+PassStatsScope::~PassStatsScope() {
+    if (!graph_) return;
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    auto& record = Statistics::Get().Record(graph_, pass_);
+    record.runs++;
+    record.time_ms += std::chrono::duration<double, std::milli>(elapsed).count();
+    auto& stats = Statistics::Get();
+    stats.AddCounter(graph_, pass_, "insts_before", insts_before_);
+    stats.AddCounter(graph_, pass_, "insts_after", CountInstructions(graph_));
+    stats.AddCounter(graph_, pass_, "blocks_before", blocks_before_);
+    stats.AddCounter(graph_, pass_, "blocks_after", static_cast<int64_t>(graph_->GetBlocks().size()));
+}
@@ -0,0 +1,130 @@
+#include "StrengthReduction.hpp"
+#include "AnalysisManager.hpp"
+#include "ConstantFolding.hpp"
+#include "LoopUtils.hpp"
+#include "Statistics.hpp"
+#include <vector>
+
+StrengthReduction::StrengthReduction(Graph* graph, AnalysisManager& am)
+    : StrengthReduction(graph, &am.Get<LoopAnalyzer>()) {}
+
+void StrengthReduction::Run() {
+    PassStatsScope stats(graph_, "StrengthReduction");
+    reduced_.clear();
+    InductionVariableAnalysis ivs(graph_, loops_);
+    ivs.Run();
+
+    std::vector<std::pair<Instruction*, InductionVariable>> muls;
+    for (auto* bb : graph_->GetRPO()) {
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            const InductionVariable* iv = ivs.Get(inst);
+            bool scaled = inst->GetOpcode() == Opcode::Mul || inst->GetOpcode() == Opcode::Shl;
+            if (scaled && iv && iv->scale != 0) muls.emplace_back(inst, *iv);
+        }
+    }
+
+    for (auto& [mul, iv] : muls) {
+        PhiInst* replacement = GetReducedVariable(iv, mul->GetType());
+        if (!replacement) continue;
+        mul->ReplaceAllUsesWith(replacement);
+        Erase(mul);
+        reduced_count_++;
+        Statistics::Count(graph_, "StrengthReduction", "reduced");
+    }
+    RemoveRedundantVariables();
+}
+
+// The new variable has to hold scale * phi + offset at the top of every
+// iteration, so it starts at scale * init + offset and moves by
+// scale * step whenever phi moves by step.
+PhiInst* StrengthReduction::GetReducedVariable(const InductionVariable& iv, Type type) {
+    IVKey key {iv.basic, iv.scale, iv.offset};
+    auto it = reduced_.find(key);
+    if (it != reduced_.end()) return it->second;
+
+    const BasicInductionVariable* basic = iv.basic;
+    BasicBlock* preheader = LoopUtils::GetPreheader(basic->loop);
+    if (!preheader) return nullptr;
+    BasicBlock* latch = basic->loop->back_edges.front();
+    Instruction* pre_end = preheader->GetLastInst();
+
+    auto new_const = [&](int64_t value) {
+        auto* constant = graph_->CreateInstruction<ConstantInst>(type, preheader, MakeConstantValue(type, value));
+        preheader->InsertBefore(pre_end, constant);
+        return constant;
+    };
+    auto new_binary = [&](Opcode opcode, BasicBlock* bb, Instruction* before, Instruction* lhs, Instruction* rhs) {
+        auto* bin = graph_->CreateInstruction<BinaryInst>(opcode, type, bb, lhs, rhs);
+        bb->InsertBefore(before, bin);
+        return bin;
+    };
+
+    Instruction* start = nullptr;
+    if (auto* init = dyn_cast<ConstantInst>(basic->init)) {
+        int64_t scaled = *FoldBinaryOp(Opcode::Mul, type, GetConstantValue(init), iv.scale);
+        start = new_const(*FoldBinaryOp(Opcode::Add, type, scaled, iv.offset));
+    } else {
+        start = basic->init;
+        if (iv.scale != 1) start = new_binary(Opcode::Mul, preheader, pre_end, start, new_const(iv.scale));
+        if (iv.offset != 0) start = new_binary(Opcode::Add, preheader, pre_end, start, new_const(iv.offset));
+    }
+    auto* step = new_const(*FoldBinaryOp(Opcode::Mul, type, iv.scale, basic->step));
+
+    auto* phi = graph_->CreateInstruction<PhiInst>(type, basic->loop->header);
+    basic->loop->header->AppendInst(phi);
+    auto* next = new_binary(Opcode::Add, latch, latch->GetLastInst(), phi, step);
+    phi->AddPhiInput(preheader, start);
+    phi->AddPhiInput(latch, next);
+    reduced_.emplace(key, phi);
+    return phi;
+}
+
+void StrengthReduction::RemoveRedundantVariables() {
+    InductionVariableAnalysis ivs(graph_, loops_);
+    ivs.Run();
+
+    auto same_init = [](const Instruction* a, const Instruction* b) {
+        auto* ca = dyn_cast<ConstantInst>(a);
+        auto* cb = dyn_cast<ConstantInst>(b);
+        return a == b || (ca && cb && GetConstantValue(ca) == GetConstantValue(cb));
+    };
+
+    const auto& basics = ivs.GetBasicVariables();
+    std::vector<bool> removed(basics.size(), false);
+    for (size_t i = 0; i < basics.size(); ++i) {
+        const BasicInductionVariable* iv = basics[i].get();
+        for (size_t j = 0; j < i; ++j) {
+            const BasicInductionVariable* kept = basics[j].get();
+            if (removed[j] || kept->loop != iv->loop || kept->step != iv->step ||
+                kept->phi->GetType() != iv->phi->GetType() || !same_init(kept->init, iv->init)) {
+                continue;
+            }
+            iv->phi->ReplaceAllUsesWith(kept->phi);
+            removed[i] = true;
+            break;
+        }
+
+        // a variable only read by its own update is dead as well
+        bool phi_dead = true;
+        for (auto* user : iv->phi->GetUsers()) phi_dead &= user == iv->update;
+        bool update_dead = true;
+        for (auto* user : iv->update->GetUsers()) update_dead &= user == iv->phi;
+        if (!removed[i] && !(phi_dead && update_dead)) continue;
+
+        iv->phi->DropInputs();
+        if (update_dead) {
+            iv->update->DropInputs();
+            Erase(iv->update);
+        }
+        Erase(iv->phi);
+        removed[i] = true;
+        removed_iv_count_++;
+        Statistics::Count(graph_, "StrengthReduction", "ivs_removed");
+    }
+}
+
+void StrengthReduction::Erase(Instruction* inst) {
+    inst->GetBasicBlock()->RemoveInst(inst);
+    inst->DropInputs();
+    graph_->FreeInstruction(inst);
+}
@@ -0,0 +1,76 @@
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+#include "IRBuilder.hpp"
+#include "BuildGraphs.hpp"
+
+void TestArenaReusesFreedSlots(TestRunner& t) {
+    ArenaAllocator arena;
+    void* a = arena.Allocate(sizeof(BinaryInst), alignof(BinaryInst));
+    void* b = arena.Allocate(sizeof(BinaryInst), alignof(BinaryInst));
+    ASSERT_NOT_EQ(a, b);
+
+    arena.Deallocate(a, sizeof(BinaryInst), alignof(BinaryInst));
+    void* c = arena.Allocate(sizeof(BinaryInst), alignof(BinaryInst));
+    ASSERT_EQ(c, a);
+    ASSERT_EQ(arena.GetChunkCount(), static_cast<size_t>(1));
+    ASSERT_EQ(arena.GetAllocationCount(), static_cast<size_t>(3));
+}
+
+void TestGraphAllocatorRouting(TestRunner& t) {
+    auto* heap = new HeapAllocator();
+    Graph graph{std::unique_ptr<GraphAllocator>(heap)};
+    IRBuilder builder(&graph);
+    auto* bb = graph.CreateNewBasicBlock();
+    graph.SetEntryBlock(bb);
+    builder.SetInsertPoint(bb);
+
+    auto* param = builder.CreateParameter(Type::int32);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateReturn(builder.CreateAdd(param, c1));
+
+    // one block + four instructions, each through the pluggable allocator
+    ASSERT_EQ(heap->GetAllocationCount(), static_cast<size_t>(5));
+
+    auto arena_graph = BuildFactorialGraph();
+    auto* arena = static_cast<ArenaAllocator*>(arena_graph->GetAllocator());
+    ASSERT_EQ(arena->GetChunkCount(), static_cast<size_t>(1));
+    ASSERT_EQ(arena->GetSystemAllocationCount(), static_cast<size_t>(1));
+}
+
+void TestSmallVectorInlineStorage(TestRunner& t) {
+    SmallVector<int, 2> vec;
+    vec.push_back(1);
+    vec.push_back(2);
+    const int* inline_data = vec.data();
+    ASSERT_EQ(vec.capacity(), static_cast<size_t>(2));
+
+    vec.push_back(3);
+    ASSERT_NOT_EQ(vec.data(), inline_data);
+    ASSERT_EQ(vec.size(), static_cast<size_t>(3));
+    ASSERT_EQ(vec[2], 3);
+
+    SmallVector<int, 2> copy = vec;
+    vec.erase(vec.begin());
+    ASSERT_EQ(vec[0], 2);
+    ASSERT_EQ(copy[0], 1);
+
+    SmallVector<int, 2> moved = std::move(copy);
+    ASSERT_EQ(moved.size(), static_cast<size_t>(3));
+    ASSERT_EQ(copy.empty(), true);
+
+    // operands beyond the inline capacity keep their use lists consistent
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* bb = graph->CreateNewBasicBlock();
+    builder.SetInsertPoint(bb);
+    auto* param = builder.CreateParameter(Type::int32);
+    auto* phi = builder.CreatePhi(Type::int32);
+    for (int i = 0; i < 10; ++i) phi->AddPhiInput(bb, param);
+
+    int uses = 0;
+    for (auto* use = param->GetFirstUse(); use; use = use->GetNext()) {
+        ASSERT_EQ(phi->GetInput(use->GetOperandIndex()), param);
+        uses++;
+    }
+    ASSERT_EQ(uses, 10);
+}
@@ -0,0 +1,101 @@
+#include "DeadCodeElimination.hpp"
+#include "Optimizer.hpp"
+#include "IRBuilder.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+static size_t CountInsts(Graph* graph) {
+    size_t count = 0;
+    for (auto& bb : graph->GetBlocks()) {
+        for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) count++;
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) count++;
+    }
+    return count;
+}
+
+void TestDCERemovesDeadValues(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    auto* orphan = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* n = builder.CreateParameter(Type::int32);
+    auto* arr = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    auto* unused = builder.CreateConstant(Type::int32, 42);
+    builder.CreateMul(builder.CreateAdd(n, unused), n);
+    builder.CreateJump(header);
+
+    // i is live through the exit compare, acc only feeds itself
+    builder.SetInsertPoint(header);
+    auto* i = builder.CreatePhi(Type::int32);
+    auto* acc = builder.CreatePhi(Type::int32);
+    builder.CreateIf(builder.CreateCmp(i, n), body, exit);
+    builder.SetInsertPoint(body);
+    auto* next_i = builder.CreateAdd(i, c1);
+    auto* next_acc = builder.CreateMul(acc, i);
+    builder.CreateStoreArray(Type::int32, arr, i, c0);
+    builder.CreateJump(header);
+    i->AddPhiInput(entry, c0);
+    i->AddPhiInput(body, next_i);
+    acc->AddPhiInput(entry, c1);
+    acc->AddPhiInput(body, next_acc);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(i);
+    builder.SetInsertPoint(orphan);
+    builder.CreateReturn(builder.CreateAdd(n, c1));
+
+    DeadCodeElimination dce(graph.get());
+    dce.Run();
+
+    // 42 with its add and mul, and the acc phi cycle; the orphan block goes whole
+    ASSERT_EQ(dce.GetRemovedCount(), static_cast<size_t>(5));
+    ASSERT_EQ(dce.GetRemovedBlockCount(), static_cast<size_t>(1));
+    ASSERT_EQ(graph->GetBlocks().size(), static_cast<size_t>(4));
+    ASSERT_EQ(CountInsts(graph.get()), static_cast<size_t>(12));
+    ASSERT_EQ(header->GetFirstPhi(), static_cast<Instruction*>(i));
+    ASSERT_EQ(header->GetLastPhi(), static_cast<Instruction*>(i));
+    ASSERT_EQ(i->GetInput(1), static_cast<Instruction*>(next_i));
+
+    // n is left with the compare only; c1 with the increment only
+    ASSERT_EQ(std::distance(n->GetUsers().begin(), n->GetUsers().end()), std::ptrdiff_t{1});
+    ASSERT_EQ(c1->GetFirstUse()->GetUser(), static_cast<Instruction*>(next_i));
+    ASSERT_EQ(c1->GetFirstUse()->GetNext(), nullptr);
+
+    DeadCodeElimination again(graph.get());
+    again.Run();
+    ASSERT_EQ(again.GetRemovedCount(), static_cast<size_t>(0));
+
+    // the counts describe the last run only
+    dce.Run();
+    ASSERT_EQ(dce.GetRemovedCount(), static_cast<size_t>(0));
+    ASSERT_EQ(dce.GetRemovedBlockCount(), static_cast<size_t>(0));
+    ASSERT_EQ(dce.GetPreservedAnalyses().IsPreserved(AnalysisKind::Dominators), true);
+}
+
+void TestDCEReusesMemory(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* bb = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(bb);
+    builder.SetInsertPoint(bb);
+    auto* p = builder.CreateParameter(Type::int32);
+    auto* dead = builder.CreateAdd(p, p);
+    builder.CreateReturn(p);
+
+    DeadCodeElimination dce(graph.get());
+    dce.Run();
+    ASSERT_EQ(p->HasUsers(), true);
+    ASSERT_EQ(dce.GetRemovedCount(), static_cast<size_t>(1));
+
+    // the swept slot is handed out again by the graph allocator
+    void* reused = graph->CreateInstruction<BinaryInst>(Opcode::Add, Type::int32, bb, p, p);
+    ASSERT_EQ(reused, static_cast<void*>(dead));
+}
@@ -0,0 +1,86 @@
+#include "GVN.hpp"
+#include "PassManager.hpp"
+#include "IRBuilder.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+void TestGVNDominatedDuplicates(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* left = graph->CreateNewBasicBlock();
+    auto* right = graph->CreateNewBasicBlock();
+    auto* join = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* a = builder.CreateParameter(Type::int32);
+    auto* b = builder.CreateParameter(Type::int32);
+    auto* c7 = builder.CreateConstant(Type::int32, 7);
+    auto* c7_dup = builder.CreateConstant(Type::int32, 7);
+    auto* c7_wide = builder.CreateConstant(Type::int64, int64_t{7});
+    auto* sum = builder.CreateAdd(a, b);
+    auto* le = builder.CreateCmp(a, b);
+    auto* ge = builder.CreateCmp(b, a);
+    builder.CreateIf(le, left, right);
+
+    builder.SetInsertPoint(left);
+    auto* sum_swapped = builder.CreateAdd(b, a);
+    auto* left_mul = builder.CreateMul(sum_swapped, c7_dup);
+    builder.CreateJump(join);
+
+    builder.SetInsertPoint(right);
+    auto* right_mul = builder.CreateMul(sum, c7);
+    builder.CreateJump(join);
+
+    builder.SetInsertPoint(join);
+    auto* join_mul = builder.CreateMul(c7, sum);
+    auto* phi = builder.CreatePhi(Type::int32);
+    phi->AddPhiInput(left, left_mul);
+    phi->AddPhiInput(right, right_mul);
+    auto* ret = builder.CreateReturn(builder.CreateOr(builder.CreateOr(phi, join_mul), builder.CreateOr(ge, c7_wide)));
+
+    DominatorAnalysis dom(graph.get());
+    dom.Run();
+    GVN pass(graph.get(), &dom);
+    pass.Run();
+
+    // c7_dup and b+a fold into their dominating twins; left_mul then
+    // matches nothing that dominates it
+    ASSERT_EQ(pass.GetRemovedCount(), static_cast<size_t>(2));
+    ASSERT_EQ(left_mul->GetInput(0), static_cast<Instruction*>(sum));
+    ASSERT_EQ(left_mul->GetInput(1), static_cast<Instruction*>(c7));
+    ASSERT_EQ(phi->GetInput(1), static_cast<Instruction*>(right_mul));
+    ASSERT_NOT_EQ(ge->GetBasicBlock(), nullptr);
+    ASSERT_EQ(c7_wide->HasUsers(), true);
+    ASSERT_EQ(join_mul->GetBasicBlock(), join);
+    ASSERT_EQ(ret->GetInput(0)->GetOpcode(), Opcode::Or);
+
+    pass.Run();
+    ASSERT_EQ(pass.GetRemovedCount(), static_cast<size_t>(0));
+    ASSERT_EQ(pass.GetPreservedAnalyses().IsPreserved(AnalysisKind::Loops), true);
+}
+
+void TestGVNInPassManager(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* next = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+    builder.SetInsertPoint(entry);
+    auto* x = builder.CreateParameter(Type::int64);
+    auto* m1 = builder.CreateMul(x, x);
+    builder.CreateJump(next);
+    builder.SetInsertPoint(next);
+    auto* m2 = builder.CreateMul(x, x);
+    auto* ret = builder.CreateReturn(builder.CreateAdd(m1, m2));
+
+    PassManager pm(graph.get());
+    pm.AddPass<GVN>();
+    pm.Run();
+
+    auto* add = ret->GetInput(0);
+    ASSERT_EQ(add->GetInput(0), static_cast<Instruction*>(m1));
+    ASSERT_EQ(add->GetInput(1), static_cast<Instruction*>(m1));
+    ASSERT_EQ(pm.GetAnalysisManager().IsCached<DominatorAnalysis>(), true);
+}
@@ -0,0 +1,60 @@
+#include "GraphCloner.hpp"
+#include "BuildGraphs.hpp"
+#include "Inliner.hpp"
+#include "IRBuilder.hpp"
+#include "Interpreter.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+std::unique_ptr<Graph> BuildCalleeGraph();
+
+namespace {
+size_t CountConstants(Graph* graph) {
+    size_t count = 0;
+    for (auto* bb : graph->GetRPO()) {
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) count += isa<ConstantInst>(inst);
+    }
+    return count;
+}
+} // namespace
+
+// the copy keeps working once the original is gone
+void TestGraphClonerCloneGraph(TestRunner& t) {
+    auto graph = BuildFactorialGraph();
+    int64_t expected = Interpret(graph.get(), {5});
+    auto clone = graph->Clone();
+    ASSERT_NOT_EQ(clone->GetEntryBlock(), graph->GetEntryBlock());
+    ASSERT_EQ(clone->GetRPO().size(), graph->GetRPO().size());
+    ASSERT_EQ(CountConstants(clone.get()), CountConstants(graph.get()));
+    graph.reset();
+
+    ASSERT_EQ(Interpret(clone.get(), {5}), expected);
+    ASSERT_EQ(Interpret(clone.get(), {5}), 120);
+    ASSERT_EQ(Interpret(clone.get(), {1}), 1);
+}
+
+// both inlined copies and the caller share the entry constants 1 and 10
+void TestGraphClonerSharesConstants(TestRunner& t) {
+    auto callee = BuildCalleeGraph();
+    auto caller = std::make_unique<Graph>();
+    IRBuilder builder(caller.get());
+    auto* entry = caller->CreateNewBasicBlock();
+    auto* body = caller->CreateNewBasicBlock();
+    caller->SetEntryBlock(entry);
+    builder.SetInsertPoint(entry);
+    auto* a = builder.CreateParameter(Type::int32);
+    auto* b = builder.CreateParameter(Type::int32);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateJump(body);
+    builder.SetInsertPoint(body);
+    auto* first = builder.CreateCall(Type::int32, callee.get(), {a, b});
+    auto* second = builder.CreateCall(Type::int32, callee.get(), {b, a});
+    builder.CreateReturn(builder.CreateAdd(builder.CreateAdd(first, second), c1));
+    int64_t expected = Interpret(callee.get(), {3, 20}) + Interpret(callee.get(), {20, 3}) + 1;
+
+    Inliner inliner(caller.get());
+    inliner.Run();
+    ASSERT_EQ(inliner.GetInlinedCount(), static_cast<size_t>(2));
+    ASSERT_EQ(CountConstants(caller.get()), static_cast<size_t>(2));
+    ASSERT_EQ(Interpret(caller.get(), {3, 20}), expected);
+}
@@ -83,4 +83,126 @@ void TestInliningSlideExample(TestRunner& t) {
     }
     ASSERT_EQ(has_call, false);
     ASSERT_NOT_EQ(caller->GetBlocks().size(), static_cast<size_t>(3));
-}
\ No newline at end of file
+}
+
+static size_t CountCalls(Graph* graph) {
+    size_t count = 0;
+    for (const auto& bb : graph->GetBlocks()) {
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (isa<CallInst>(inst)) count++;
+        }
+    }
+    return count;
+}
+
+// g(p) = p + p + ... + p with `adds` additions
+static std::unique_ptr<Graph> BuildChainCallee(size_t adds) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* bb = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(bb);
+    builder.SetInsertPoint(bb);
+    Instruction* param = builder.CreateParameter(Type::int32);
+    Instruction* acc = param;
+    for (size_t i = 0; i < adds; ++i) acc = builder.CreateAdd(acc, param);
+    builder.CreateReturn(acc);
+    return graph;
+}
+
+// f(n) = n <= 0 ? 0 : f(n + -1)
+void TestInliningRecursionLimit(TestRunner& t) {
+    auto callee = std::make_unique<Graph>();
+    {
+        IRBuilder builder(callee.get());
+        auto* entry = callee->CreateNewBasicBlock();
+        auto* recurse = callee->CreateNewBasicBlock();
+        auto* done = callee->CreateNewBasicBlock();
+        callee->SetEntryBlock(entry);
+        builder.SetInsertPoint(entry);
+        auto* n = builder.CreateParameter(Type::int32);
+        auto* c0 = builder.CreateConstant(Type::int32, 0);
+        auto* cm1 = builder.CreateConstant(Type::int32, -1);
+        builder.CreateIf(builder.CreateCmp(n, c0), done, recurse);
+        builder.SetInsertPoint(recurse);
+        builder.CreateReturn(builder.CreateCall(Type::int32, callee.get(), {builder.CreateAdd(n, cm1)}));
+        builder.SetInsertPoint(done);
+        builder.CreateReturn(c0);
+    }
+
+    for (size_t limit : {size_t{1}, size_t{3}, size_t{5}}) {
+        auto caller = std::make_unique<Graph>();
+        IRBuilder builder(caller.get());
+        auto* bb = caller->CreateNewBasicBlock();
+        caller->SetEntryBlock(bb);
+        builder.SetInsertPoint(bb);
+        auto* arg = builder.CreateParameter(Type::int32);
+        builder.CreateReturn(builder.CreateCall(Type::int32, callee.get(), {arg}));
+
+        Inliner inliner(caller.get());
+        // deep enough that only the recursion limit stops inlining
+        inliner.SetMaxDepth(limit + 4);
+        inliner.SetRecursionLimit(limit);
+        inliner.Run();
+        // f appears on the chain once per copy; the innermost call stays
+        ASSERT_EQ(inliner.GetInlinedCount(), limit);
+        ASSERT_EQ(CountCalls(caller.get()), static_cast<size_t>(1));
+    }
+}
+
+// the same callee is too big for a straight-line call but not for one in a loop
+void TestInliningPrefersLoopCalls(TestRunner& t) {
+    auto callee = BuildChainCallee(45);
+    for (size_t budget : {size_t{400}, size_t{40}}) {
+        auto caller = std::make_unique<Graph>();
+        IRBuilder builder(caller.get());
+        auto* entry = caller->CreateNewBasicBlock();
+        auto* header = caller->CreateNewBasicBlock();
+        auto* body = caller->CreateNewBasicBlock();
+        auto* exit = caller->CreateNewBasicBlock();
+        caller->SetEntryBlock(entry);
+
+        builder.SetInsertPoint(entry);
+        auto* n = builder.CreateParameter(Type::int32);
+        auto* x = builder.CreateParameter(Type::int32);
+        auto* c0 = builder.CreateConstant(Type::int32, 0);
+        auto* c1 = builder.CreateConstant(Type::int32, 1);
+        auto* cold = builder.CreateCall(Type::int32, callee.get(), {x});
+        builder.CreateJump(header);
+        builder.SetInsertPoint(header);
+        auto* i = builder.CreatePhi(Type::int32);
+        builder.CreateIf(builder.CreateCmp(i, n), body, exit);
+        builder.SetInsertPoint(body);
+        builder.CreateCall(Type::int32, callee.get(), {x});
+        auto* i_next = builder.CreateAdd(i, c1);
+        builder.CreateJump(header);
+        builder.SetInsertPoint(exit);
+        builder.CreateReturn(cold);
+        i->AddPhiInput(entry, c0);
+        i->AddPhiInput(body, i_next);
+
+        Inliner inliner(caller.get());
+        inliner.SetGrowthBudget(budget);
+        inliner.Run();
+        ASSERT_EQ(inliner.GetInlinedCount(), static_cast<size_t>(budget == 400 ? 1 : 0));
+        ASSERT_EQ(CountCalls(caller.get()), static_cast<size_t>(budget == 400 ? 1 : 2));
+        ASSERT_EQ(cold->GetBasicBlock(), entry);
+    }
+}
+
+void TestInliningConstantArguments(TestRunner& t) {
+    auto callee = BuildChainCallee(45);
+    for (bool constant : {true, false}) {
+        auto caller = std::make_unique<Graph>();
+        IRBuilder builder(caller.get());
+        auto* bb = caller->CreateNewBasicBlock();
+        caller->SetEntryBlock(bb);
+        builder.SetInsertPoint(bb);
+        Instruction* arg = constant ? static_cast<Instruction*>(builder.CreateConstant(Type::int32, 2))
+                                    : builder.CreateParameter(Type::int32);
+        builder.CreateReturn(builder.CreateCall(Type::int32, callee.get(), {arg}));
+
+        Inliner inliner(caller.get());
+        inliner.Run();
+        ASSERT_EQ(inliner.GetInlinedCount(), static_cast<size_t>(constant ? 1 : 0));
+    }
+}
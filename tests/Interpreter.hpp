@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ConstantFolding.hpp"
+#include "Graph.hpp"
+#include "GraphMaps.hpp"
+
+// Reference evaluator for scalar graphs, used to check that a transform
+// keeps the result. Phis of a block read their inputs from the edge taken
+// all at once. Returns the value of the first Ret reached, or
+// kInterpretTrap when a BoundsCheck fails. Arrays are plain integers and
+// a[i] reads as a + i.
+constexpr int64_t kInterpretTrap = INT64_MIN;
+
+inline int64_t Interpret(Graph* graph, const std::vector<int64_t>& args) {
+    InstMap<int64_t> values(graph, 0);
+    size_t next_arg = 0;
+    BasicBlock* prev = nullptr;
+    BasicBlock* bb = graph->GetEntryBlock();
+    for (size_t steps = 0; steps < 1000000; ++steps) {
+        std::vector<std::pair<Instruction*, int64_t>> phi_values;
+        for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) {
+            for (auto [from, value] : cast<PhiInst>(inst)->GetPhiInputs()) {
+                if (from == prev) phi_values.emplace_back(inst, values[value]);
+            }
+        }
+        for (auto& [phi, value] : phi_values) values[phi] = value;
+
+        BasicBlock* next = nullptr;
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            switch (inst->GetOpcode()) {
+                case Opcode::Param:
+                    values[inst] = args[next_arg++];
+                    break;
+                case Opcode::Const:
+                    values[inst] = GetConstantValue(cast<ConstantInst>(inst));
+                    break;
+                case Opcode::Jump:
+                    next = cast<JumpInst>(inst)->GetTarget();
+                    break;
+                case Opcode::If: {
+                    auto* branch = cast<IfInst>(inst);
+                    next = values[branch->GetInput(0)] ? branch->GetTrueTarget() : branch->GetFalseTarget();
+                    break;
+                }
+                case Opcode::NullCheck:
+                    values[inst] = values[inst->GetInput(0)];
+                    break;
+                case Opcode::BoundsCheck: {
+                    int64_t index = values[inst->GetInput(0)];
+                    if (index < 0 || index >= values[inst->GetInput(1)]) return kInterpretTrap;
+                    values[inst] = index;
+                    break;
+                }
+                case Opcode::LoadArray:
+                    values[inst] = values[inst->GetInput(0)] + values[inst->GetInput(1)];
+                    break;
+                case Opcode::Ret:
+                    return inst->GetInputs().empty() ? 0 : values[inst->GetInput(0)];
+                default:
+                    assert(isa<BinaryInst>(inst) && "Interpret only handles scalar code");
+                    values[inst] = *FoldBinaryOp(inst->GetOpcode(), inst->GetType(),
+                        values[inst->GetInput(0)], values[inst->GetInput(1)]);
+                    break;
+            }
+        }
+        prev = bb;
+        bb = next;
+    }
+    assert(false && "Interpret ran out of steps");
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "LICM.hpp"
+#include "LoopUtils.hpp"
+#include "PassManager.hpp"
+#include "IRBuilder.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+// header is entered from two blocks with different phi values, so a
+// preheader has to be created (and the entering values merged) first
+void TestLICMInsertsPreheader(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* left = graph->CreateNewBasicBlock();
+    auto* right = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* p = builder.CreateParameter(Type::int32);
+    auto* n = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateIf(p, left, right);
+    builder.SetInsertPoint(left);
+    builder.CreateJump(header);
+    builder.SetInsertPoint(right);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(header);
+    auto* i = builder.CreatePhi(Type::int32);
+    auto* bound = builder.CreateMul(n, n);
+    builder.CreateIf(builder.CreateCmp(i, bound), body, exit);
+    builder.SetInsertPoint(body);
+    auto* step = builder.CreateAdd(p, c1);
+    auto* next = builder.CreateAdd(i, step);
+    builder.CreateJump(header);
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(i);
+    i->AddPhiInput(left, c0);
+    i->AddPhiInput(right, c1);
+    i->AddPhiInput(body, next);
+
+    DominatorAnalysis dom(graph.get());
+    dom.Run();
+    LoopAnalyzer loops(graph.get(), &dom);
+    loops.Run();
+    LICM licm(graph.get(), &dom, &loops);
+    licm.Run();
+
+    ASSERT_EQ(licm.GetPreheaderCount(), static_cast<size_t>(1));
+    ASSERT_EQ(licm.GetHoistedCount(), static_cast<size_t>(2));
+    BasicBlock* preheader = LoopUtils::GetPreheader(loops.GetLoops()[0].get());
+    ASSERT_NOT_EQ(preheader, static_cast<BasicBlock*>(nullptr));
+    ASSERT_EQ(header->GetPreds().size(), static_cast<size_t>(2));
+    ASSERT_EQ(left->GetSuccs()[0], preheader);
+    ASSERT_EQ(cast<JumpInst>(right->GetLastInst())->GetTarget(), preheader);
+    ASSERT_EQ(dom.GetIdom(header), preheader);
+
+    // the two entering values meet in a phi of the preheader
+    auto* merged = cast<PhiInst>(preheader->GetFirstPhi());
+    ASSERT_EQ(merged->GetInputs().size(), static_cast<size_t>(2));
+    ASSERT_EQ(i->GetInputs().size(), static_cast<size_t>(2));
+    ASSERT_EQ(i->GetPhiInputs()[1].first, preheader);
+    ASSERT_EQ(i->GetPhiInputs()[1].second, static_cast<Instruction*>(merged));
+
+    ASSERT_EQ(bound->GetBasicBlock(), preheader);
+    ASSERT_EQ(step->GetBasicBlock(), preheader);
+    ASSERT_EQ(next->GetBasicBlock(), body);
+    ASSERT_EQ(preheader->GetLastInst()->GetOpcode(), Opcode::Jump);
+}
+
+// for (i) { for (j) { x = a * a; y = x + i; null check of obj } }
+void TestLICMNestedLoops(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* outer = graph->CreateNewBasicBlock();
+    auto* inner = graph->CreateNewBasicBlock();
+    auto* inner_body = graph->CreateNewBasicBlock();
+    auto* outer_latch = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* a = builder.CreateParameter(Type::int32);
+    auto* obj = builder.CreateParameter(Type::int64);
+    auto* n = builder.CreateParameter(Type::int32);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateJump(outer);
+
+    builder.SetInsertPoint(outer);
+    auto* i = builder.CreatePhi(Type::int32);
+    builder.CreateIf(builder.CreateCmp(i, n), inner, exit);
+
+    builder.SetInsertPoint(inner);
+    auto* j = builder.CreatePhi(Type::int32);
+    auto* check = builder.CreateNullCheck(obj);
+    builder.CreateIf(builder.CreateCmp(j, n), inner_body, outer_latch);
+
+    builder.SetInsertPoint(inner_body);
+    auto* x = builder.CreateMul(a, a);
+    auto* y = builder.CreateAdd(x, i);
+    auto* body_check = builder.CreateNullCheck(obj);
+    auto* j_next = builder.CreateAdd(j, y);
+    builder.CreateJump(inner);
+
+    builder.SetInsertPoint(outer_latch);
+    auto* i_next = builder.CreateAdd(i, c1);
+    builder.CreateJump(outer);
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(i);
+
+    i->AddPhiInput(entry, c1);
+    i->AddPhiInput(outer_latch, i_next);
+    j->AddPhiInput(outer, c1);
+    j->AddPhiInput(inner_body, j_next);
+
+    PassManager pm(graph.get());
+    pm.AddPass<LICM>();
+    pm.Run();
+
+    // loops were recomputed in place after the inner preheader went in
+    ASSERT_EQ(pm.GetAnalysisManager().IsCached<LoopAnalyzer>(), true);
+    ASSERT_EQ(graph->GetBlocks().size(), static_cast<size_t>(7));
+    auto& loops = pm.GetAnalysisManager().Get<LoopAnalyzer>();
+    Loop* inner_loop = loops.GetLoopFor(inner);
+    BasicBlock* inner_preheader = LoopUtils::GetPreheader(inner_loop);
+    ASSERT_EQ(inner_loop->parent_loop->Contains(inner_preheader), true);
+
+    // x leaves the whole nest, y depends on i and stops in the inner preheader
+    ASSERT_EQ(x->GetBasicBlock(), entry);
+    ASSERT_EQ(y->GetBasicBlock(), inner_preheader);
+    // the inner header check runs on every inner iteration but the outer
+    // loop may exit before reaching it; the body check may never run
+    ASSERT_EQ(check->GetBasicBlock(), inner_preheader);
+    ASSERT_EQ(body_check->GetBasicBlock(), inner_body);
+    ASSERT_EQ(j_next->GetBasicBlock(), inner_body);
+    ASSERT_EQ(i_next->GetBasicBlock(), outer_latch);
+}
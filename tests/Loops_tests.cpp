@@ -37,4 +37,66 @@ void TestLoops(TestRunner& t) {
     ASSERT_EQ(loop->parent_loop, root);
     loop_analyzer.Dump();
     std::cout << "Loop Analysis test passed!" << std::endl;
-}
\ No newline at end of file
+}
+void TestRPOCachedAndIterative(TestRunner& t) {
+    auto graph = BuildFactorialGraph();
+    const auto& blocks = graph->GetBlocks();
+    BasicBlock* entry = blocks[0].get();
+    BasicBlock* header = blocks[1].get();
+    BasicBlock* body = blocks[2].get();
+    BasicBlock* exit = blocks[3].get();
+
+    const auto& rpo = graph->GetRPO();
+    ASSERT_EQ(rpo.size(), static_cast<size_t>(4));
+    ASSERT_EQ(rpo[0], entry);
+    ASSERT_EQ(rpo[1], header);
+    ASSERT_EQ(rpo[2], exit);
+    ASSERT_EQ(rpo[3], body);
+    ASSERT_EQ(&graph->GetRPO(), &rpo);
+
+    // a new edge drops the cached order
+    auto* extra = graph->CreateNewBasicBlock();
+    ASSERT_EQ(graph->GetRPO().size(), static_cast<size_t>(4));
+    exit->LinkTo(extra);
+    ASSERT_EQ(graph->GetRPO().size(), static_cast<size_t>(5));
+    ASSERT_EQ(graph->GetRPO()[3], extra);
+
+    // deep chains must not exhaust the native stack
+    Graph chain;
+    constexpr int kDepth = 200000;
+    BasicBlock* prev = chain.CreateNewBasicBlock();
+    chain.SetEntryBlock(prev);
+    for (int i = 1; i < kDepth; ++i) {
+        BasicBlock* next = chain.CreateNewBasicBlock();
+        prev->LinkTo(next);
+        prev = next;
+    }
+    ASSERT_EQ(chain.GetRPO().size(), static_cast<size_t>(kDepth));
+    ASSERT_EQ(chain.GetRPO().back(), prev);
+}
+
+void TestBlockAndInstMaps(TestRunner& t) {
+    auto graph = BuildFactorialGraph();
+    const auto& blocks = graph->GetBlocks();
+    BasicBlock* header = blocks[1].get();
+
+    BlockMap<int> depth(graph.get(), -1);
+    ASSERT_EQ(depth.size(), graph->GetBlockIdBound());
+    ASSERT_EQ(depth.Get(header), -1);
+    depth[header] = 1;
+    ASSERT_EQ(depth.Get(header), 1);
+
+    // blocks created after sizing read as the default and grow on write
+    auto* late = graph->CreateNewBasicBlock();
+    ASSERT_EQ(depth.Get(late), -1);
+    depth[late] = 3;
+    ASSERT_EQ(depth.size(), graph->GetBlockIdBound());
+    ASSERT_EQ(depth.Get(late), 3);
+
+    InstMap<bool> seen(graph.get(), false);
+    Instruction* first = header->GetFirstPhi();
+    ASSERT_EQ(seen.Get(first), false);
+    seen[first] = true;
+    ASSERT_EQ(seen.Get(first), true);
+    ASSERT_EQ(seen.Get(first->GetId() + 1000), false);
+}
@@ -1,5 +1,6 @@
 #include "DominatorAnalysis.hpp"
 #include "Optimizer.hpp"
+#include "PatternMatch.hpp"
 #include "TestRunner.hpp"
 #include "TestsUtils.hpp"
 
@@ -8,7 +9,7 @@ int64_t GetConstVal(Instruction* inst) {
         throw std::runtime_error("GetConstVal failed: Instruction is nullptr");
     }
     
-    auto* const_inst = dynamic_cast<ConstantInst*>(inst);
+    auto* const_inst = dyn_cast<ConstantInst>(inst);
     if (!const_inst) {
         throw std::runtime_error("GetConstVal failed: Instruction is NOT a ConstantInst (Opcode: " + 
                                  std::to_string(static_cast<int>(inst->GetOpcode())) + ")");
@@ -120,3 +121,293 @@ void TestPeepholeAshr(TestRunner& t) {
     ASSERT_EQ(res_zero->GetOpcode(), Opcode::Const);
     ASSERT_EQ(GetConstVal(res_zero), 0);
 }
+
+void TestPatternMatch(TestRunner& t) {
+    using namespace PatternMatch;
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* bb = graph->CreateNewBasicBlock();
+    builder.SetInsertPoint(bb);
+
+    auto* param = builder.CreateParameter(Type::int32);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    auto* c8 = builder.CreateConstant(Type::int32, 8);
+    auto* mul = builder.CreateMul(c1, param);
+    auto* scaled = builder.CreateMul(param, c8);
+
+    Instruction* x = nullptr;
+    ASSERT_EQ(Match(mul, m_Mul(m_Value(x), m_ConstInt(1))), false);
+    ASSERT_EQ(Match(mul, m_c_Mul(m_Value(x), m_ConstInt(1))), true);
+    ASSERT_EQ(x, static_cast<Instruction*>(param));
+    ASSERT_EQ(Match(mul, m_Add(m_Value(), m_Value())), false);
+    int64_t log2 = 0;
+    ASSERT_EQ(Match(scaled, m_Mul(m_Specific(param), m_PowerOfTwo(log2))), true);
+    ASSERT_EQ(log2, 3);
+    ASSERT_EQ(Match(mul, m_Mul(m_Value(), m_PowerOfTwo(log2))), false);
+    ASSERT_EQ(Match(scaled, m_Mul(m_Value(x), m_Deferred(x))), false);
+}
+
+void TestPeepholeSubAndShift(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* bb = graph->CreateNewBasicBlock();
+    builder.SetInsertPoint(bb);
+
+    auto* x = builder.CreateParameter(Type::int32);
+    auto* y = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c3 = builder.CreateConstant(Type::int32, 3);
+    auto* c8 = builder.CreateConstant(Type::int32, 8);
+
+    auto* ret_neg = builder.CreateReturn(builder.CreateSub(c0, builder.CreateSub(c0, x)));
+    auto* ret_cancel = builder.CreateReturn(builder.CreateSub(builder.CreateAdd(x, y), x));
+    auto* ret_self = builder.CreateReturn(builder.CreateSub(y, y));
+    auto* ret_shift = builder.CreateReturn(builder.CreateMul(c8, x));
+    auto* ret_double = builder.CreateReturn(builder.CreateAdd(x, x));
+    auto* ret_offset = builder.CreateReturn(builder.CreateAdd(builder.CreateSub(x, c3), c8));
+    auto* ret_shl = builder.CreateReturn(builder.CreateShl(builder.CreateShl(y, c3), c3));
+
+    Optimizer opt(graph.get());
+    opt.Run();
+
+    ASSERT_EQ(ret_neg->GetInput(0), static_cast<Instruction*>(x));
+    ASSERT_EQ(ret_cancel->GetInput(0), static_cast<Instruction*>(y));
+    ASSERT_EQ(GetConstVal(ret_self->GetInput(0)), 0);
+
+    Instruction* shift = ret_shift->GetInput(0);
+    ASSERT_EQ(shift->GetOpcode(), Opcode::Shl);
+    ASSERT_EQ(shift->GetInput(0), static_cast<Instruction*>(x));
+    ASSERT_EQ(GetConstVal(shift->GetInput(1)), 3);
+
+    Instruction* doubled = ret_double->GetInput(0);
+    ASSERT_EQ(doubled->GetOpcode(), Opcode::Shl);
+    ASSERT_EQ(GetConstVal(doubled->GetInput(1)), 1);
+
+    // x - 3 + 8 = x + 5
+    Instruction* offset = ret_offset->GetInput(0);
+    ASSERT_EQ(offset->GetOpcode(), Opcode::Add);
+    ASSERT_EQ(offset->GetInput(0), static_cast<Instruction*>(x));
+    ASSERT_EQ(GetConstVal(offset->GetInput(1)), 5);
+
+    Instruction* shl = ret_shl->GetInput(0);
+    ASSERT_EQ(shl->GetInput(0), static_cast<Instruction*>(y));
+    ASSERT_EQ(GetConstVal(shl->GetInput(1)), 6);
+}
+
+namespace {
+class OpcodeCounter : public InstVisitor<OpcodeCounter> {
+public:
+    int binaries = 0;
+    int constants = 0;
+    int others = 0;
+
+    void VisitBinary(BinaryInst*) { binaries++; }
+    void VisitConst(ConstantInst*) { constants++; }
+    void VisitInstruction(Instruction*) { others++; }
+};
+} // namespace
+
+void TestInstVisitorDispatch(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* bb = graph->CreateNewBasicBlock();
+    builder.SetInsertPoint(bb);
+
+    auto* param = builder.CreateParameter(Type::int32);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    auto* add = builder.CreateAdd(param, c1);
+    auto* cmp = builder.CreateCmp(add, c1);
+    builder.CreateReturn(cmp);
+
+    OpcodeCounter counter;
+    for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+        counter.Visit(inst);
+    }
+    ASSERT_EQ(counter.binaries, 2);
+    ASSERT_EQ(counter.constants, 1);
+    ASSERT_EQ(counter.others, 2);
+
+    Instruction* as_inst = add;
+    ASSERT_EQ(isa<BinaryInst>(as_inst), true);
+    ASSERT_EQ(isa<ConstantInst>(as_inst), false);
+    ASSERT_EQ(dyn_cast<ConstantInst>(as_inst), nullptr);
+    ASSERT_EQ(cast<BinaryInst>(as_inst), add);
+    ASSERT_EQ(dyn_cast<ConstantInst>(static_cast<Instruction*>(c1)), c1);
+}
+
+void TestUseListReplaceAllUses(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* bb = graph->CreateNewBasicBlock();
+    builder.SetInsertPoint(bb);
+
+    auto* param = builder.CreateParameter(Type::int32);
+    auto* c2 = builder.CreateConstant(Type::int32, 2);
+    auto* add = builder.CreateAdd(param, param);
+    auto* mul = builder.CreateMul(add, c2);
+    auto* phi = builder.CreatePhi(Type::int32);
+    for (int i = 0; i < 5; ++i) {
+        phi->AddPhiInput(bb, param);
+    }
+
+    int param_uses = 0;
+    for (auto* user : param->GetUsers()) {
+        ASSERT_EQ(user == add || user == phi, true);
+        param_uses++;
+    }
+    ASSERT_EQ(param_uses, 7);
+    ASSERT_EQ(param->GetFirstUse()->Get(), param);
+
+    param->ReplaceAllUsesWith(c2);
+    ASSERT_EQ(param->HasUsers(), false);
+    ASSERT_EQ(add->GetInput(0), c2);
+    ASSERT_EQ(add->GetInput(1), c2);
+    ASSERT_EQ(phi->GetPhiInputs()[4].second, c2);
+
+    int c2_uses = 0;
+    for (auto* use = c2->GetFirstUse(); use; use = use->GetNext()) {
+        ASSERT_EQ(use->GetUser()->GetInput(use->GetOperandIndex()), c2);
+        c2_uses++;
+    }
+    ASSERT_EQ(c2_uses, 8);
+
+    mul->DropInputs();
+    ASSERT_EQ(add->HasUsers(), false);
+}
+
+void TestWorklistLongChains(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* bb = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(bb);
+    builder.SetInsertPoint(bb);
+
+    constexpr int kLength = 2000;
+    auto* param = builder.CreateParameter(Type::int64);
+    auto* c1 = builder.CreateConstant(Type::int64, int64_t{1});
+    auto* c3 = builder.CreateConstant(Type::int64, int64_t{3});
+    Instruction* ident = param;
+    Instruction* folded = c1;
+    for (int i = 0; i < kLength; ++i) {
+        ident = builder.CreateMul(ident, c1);
+        folded = builder.CreateOr(folded, c3);
+    }
+    auto* ret1 = builder.CreateReturn(ident);
+    auto* ret2 = builder.CreateReturn(folded);
+
+    Optimizer opt(graph.get());
+    opt.Run();
+
+    ASSERT_EQ(ret1->GetInput(0), static_cast<Instruction*>(param));
+    ASSERT_EQ(GetConstVal(ret2->GetInput(0)), 3);
+
+    // every Mul and Or is gone, only the constants they folded into remain
+    size_t binaries = 0;
+    for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+        if (isa<BinaryInst>(inst)) binaries++;
+    }
+    ASSERT_EQ(binaries, static_cast<size_t>(0));
+}
+
+void TestFoldingWraparound(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* bb = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(bb);
+    builder.SetInsertPoint(bb);
+
+    auto* max32 = builder.CreateConstant(Type::int32, INT32_MAX);
+    auto* one32 = builder.CreateConstant(Type::int32, 1);
+    auto* big64 = builder.CreateConstant(Type::int64, int64_t{1} << 62);
+    auto* four64 = builder.CreateConstant(Type::int64, int64_t{4});
+    auto* minus8 = builder.CreateConstant(Type::int32, -8);
+    auto* c33 = builder.CreateConstant(Type::int32, 33);
+
+    auto* ret_add = builder.CreateReturn(builder.CreateAdd(max32, one32));
+    auto* ret_mul = builder.CreateReturn(builder.CreateMul(big64, four64));
+    auto* ret_shr = builder.CreateReturn(builder.CreateShr(minus8, c33));
+    auto* ret_le = builder.CreateReturn(builder.CreateCmp(one32, max32));
+    auto* ret_gt = builder.CreateReturn(builder.CreateCmp(max32, one32));
+
+    Optimizer opt(graph.get());
+    opt.Run();
+
+    ASSERT_EQ(GetConstVal(ret_add->GetInput(0)), INT32_MIN);
+    ASSERT_EQ(ret_add->GetInput(0)->GetType(), Type::int32);
+    ASSERT_EQ(GetConstVal(ret_mul->GetInput(0)), 0);
+    // shift counts are taken modulo the width: -8 >> (33 & 31)
+    ASSERT_EQ(GetConstVal(ret_shr->GetInput(0)), -4);
+    ASSERT_EQ(GetConstVal(ret_le->GetInput(0)), 1);
+    ASSERT_EQ(GetConstVal(ret_gt->GetInput(0)), 0);
+}
+
+void TestBranchFolding(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* then_bb = graph->CreateNewBasicBlock();
+    auto* else_bb = graph->CreateNewBasicBlock();
+    auto* else_tail = graph->CreateNewBasicBlock();
+    auto* join = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* a = builder.CreateParameter(Type::int32);
+    auto* b = builder.CreateParameter(Type::int32);
+    auto* c2 = builder.CreateConstant(Type::int32, 2);
+    auto* c5 = builder.CreateConstant(Type::int32, 5);
+    builder.CreateIf(builder.CreateCmp(c2, c5), then_bb, else_bb);
+    builder.SetInsertPoint(then_bb);
+    builder.CreateJump(join);
+    builder.SetInsertPoint(else_bb);
+    auto* dead_mul = builder.CreateMul(b, c5);
+    builder.CreateJump(else_tail);
+    builder.SetInsertPoint(else_tail);
+    builder.CreateJump(join);
+    builder.SetInsertPoint(join);
+    auto* phi = builder.CreatePhi(Type::int32);
+    phi->AddPhiInput(then_bb, a);
+    phi->AddPhiInput(else_tail, dead_mul);
+    auto* ret = builder.CreateReturn(phi);
+
+    Optimizer opt(graph.get());
+    opt.Run();
+
+    ASSERT_EQ(entry->GetLastInst()->GetOpcode(), Opcode::Jump);
+    ASSERT_EQ(static_cast<JumpInst*>(entry->GetLastInst())->GetTarget(), then_bb);
+    ASSERT_EQ(entry->GetSuccs().size(), static_cast<size_t>(1));
+    ASSERT_EQ(graph->GetBlocks().size(), static_cast<size_t>(3));
+    ASSERT_EQ(join->GetPreds().size(), static_cast<size_t>(1));
+    ASSERT_EQ(join->GetFirstPhi(), nullptr);
+    ASSERT_EQ(ret->GetInput(0), static_cast<Instruction*>(a));
+    ASSERT_EQ(b->HasUsers(), false);
+    ASSERT_EQ(graph->GetRPO().size(), static_cast<size_t>(3));
+}
+
+void TestSelfReferencingPhi(TestRunner& t) {
+    // heap allocated, so a use of the freed phi is a real use-after-free
+    auto graph = std::make_unique<Graph>(std::make_unique<HeapAllocator>());
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* a = builder.CreateParameter(Type::int32);
+    auto* b = builder.CreateParameter(Type::int32);
+    builder.CreateJump(header);
+    builder.SetInsertPoint(header);
+    auto* phi = builder.CreatePhi(Type::int32);
+    phi->AddPhiInput(entry, a);
+    phi->AddPhiInput(header, phi);
+    builder.CreateIf(builder.CreateCmp(b, a), header, exit);
+    builder.SetInsertPoint(exit);
+    auto* ret = builder.CreateReturn(phi);
+
+    Optimizer opt(graph.get());
+    opt.Run();
+
+    ASSERT_EQ(header->GetFirstPhi(), nullptr);
+    ASSERT_EQ(ret->GetInput(0), static_cast<Instruction*>(a));
+}
@@ -0,0 +1,80 @@
+#include "PassManager.hpp"
+#include "Optimizer.hpp"
+#include "CheckElimination.hpp"
+#include "Inliner.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+#include "BuildGraphs.hpp"
+
+static size_t CountOpcode(Graph* graph, Opcode opcode) {
+    size_t count = 0;
+    for (auto& bb : graph->GetBlocks()) {
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (inst->GetOpcode() == opcode) count++;
+        }
+    }
+    return count;
+}
+
+void TestAnalysisManagerCaching(TestRunner& t) {
+    auto graph = BuildFactorialGraph();
+    AnalysisManager am(graph.get());
+
+    auto& liveness = am.Get<LivenessAnalysis>();
+    ASSERT_EQ(&am.Get<LivenessAnalysis>(), &liveness);
+    ASSERT_EQ(am.GetComputeCount(AnalysisKind::Dominators), static_cast<size_t>(1));
+    ASSERT_EQ(am.GetComputeCount(AnalysisKind::Loops), static_cast<size_t>(1));
+    ASSERT_EQ(am.GetComputeCount(AnalysisKind::LinearOrder), static_cast<size_t>(1));
+    ASSERT_EQ(am.GetComputeCount(AnalysisKind::Liveness), static_cast<size_t>(1));
+    ASSERT_EQ(am.Get<LoopAnalyzer>().GetLoops().size(), static_cast<size_t>(1));
+
+    // instruction-only changes keep the CFG analyses
+    am.Invalidate(PreservedAnalyses::CFG());
+    ASSERT_EQ(am.IsCached<DominatorAnalysis>(), true);
+    ASSERT_EQ(am.IsCached<LinearOrderBuilder>(), true);
+    ASSERT_EQ(am.IsCached<LivenessAnalysis>(), false);
+    am.Get<LivenessAnalysis>();
+    ASSERT_EQ(am.GetComputeCount(AnalysisKind::Loops), static_cast<size_t>(1));
+    ASSERT_EQ(am.GetComputeCount(AnalysisKind::Liveness), static_cast<size_t>(2));
+
+    // dropping dominators drops everything built on top of them
+    am.Invalidate(PreservedAnalyses::All().Abandon(AnalysisKind::Dominators));
+    ASSERT_EQ(am.IsCached<DominatorAnalysis>(), false);
+    ASSERT_EQ(am.IsCached<LoopAnalyzer>(), false);
+    ASSERT_EQ(am.IsCached<LinearOrderBuilder>(), false);
+    ASSERT_EQ(am.IsCached<LivenessAnalysis>(), false);
+}
+
+void TestPassManagerPreservedAnalyses(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* next = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+    builder.SetInsertPoint(entry);
+    auto* arr = builder.CreateParameter(Type::int32);
+    auto* c2 = builder.CreateConstant(Type::int32, 2);
+    auto* c3 = builder.CreateConstant(Type::int32, 3);
+    auto* mul = builder.CreateMul(c2, c3);
+    auto* nc1 = builder.CreateNullCheck(arr);
+    builder.CreateJump(next);
+    builder.SetInsertPoint(next);
+    builder.CreateLoadArray(Type::int32, builder.CreateNullCheck(arr), mul);
+    builder.CreateReturn(nc1);
+
+    PassManager pm(graph.get());
+    pm.AddPass<Inliner>();
+    pm.AddPass<CheckElimination>();
+    pm.AddPass<Optimizer>();
+    pm.AddPass<CheckElimination>();
+    pm.Run();
+
+    // nothing to inline, and neither folding nor check removal touch the CFG
+    auto& am = pm.GetAnalysisManager();
+    ASSERT_EQ(pm.GetPassCount(), static_cast<size_t>(4));
+    ASSERT_EQ(am.GetComputeCount(AnalysisKind::Dominators), static_cast<size_t>(1));
+    ASSERT_EQ(am.IsCached<DominatorAnalysis>(), true);
+    // the removed instructions are freed, so look at what is left instead
+    ASSERT_EQ(CountOpcode(graph.get(), Opcode::NullCheck), static_cast<size_t>(1));
+    ASSERT_EQ(CountOpcode(graph.get(), Opcode::Mul), static_cast<size_t>(0));
+}
@@ -0,0 +1,178 @@
+#include "LoopPredication.hpp"
+#include "PassManager.hpp"
+#include "IRBuilder.hpp"
+#include "Interpreter.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+// for (i = 0; i < n; i++) s += a[i + 1] + a[i + 2]
+static std::unique_ptr<Graph> BuildOffsetSumGraph() {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* arr = builder.CreateParameter(Type::int64);
+    auto* n = builder.CreateParameter(Type::int32);
+    auto* len = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    auto* c2 = builder.CreateConstant(Type::int32, 2);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(header);
+    auto* s = builder.CreatePhi(Type::int32);
+    auto* i = builder.CreatePhi(Type::int32);
+    builder.CreateIf(builder.CreateCmp(n, i), exit, body);
+
+    builder.SetInsertPoint(body);
+    auto* first = builder.CreateBoundsCheck(builder.CreateAdd(i, c1), len);
+    auto* second = builder.CreateBoundsCheck(builder.CreateAdd(i, c2), len);
+    auto* sum = builder.CreateAdd(builder.CreateLoadArray(Type::int32, arr, first),
+                                  builder.CreateLoadArray(Type::int32, arr, second));
+    auto* s_next = builder.CreateAdd(s, sum);
+    auto* i_next = builder.CreateAdd(i, c1);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(s);
+    s->AddPhiInput(entry, c0);
+    s->AddPhiInput(body, s_next);
+    i->AddPhiInput(entry, c0);
+    i->AddPhiInput(body, i_next);
+    return graph;
+}
+
+static size_t CountBoundsChecks(Graph* graph) {
+    size_t count = 0;
+    for (auto& bb : graph->GetBlocks()) {
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (isa<BoundsCheckInst>(inst)) count++;
+        }
+    }
+    return count;
+}
+
+void TestPredicationVersionsLoop(TestRunner& t) {
+    auto original = BuildOffsetSumGraph();
+    auto graph = BuildOffsetSumGraph();
+    DominatorAnalysis dom(graph.get());
+    dom.Run();
+    LoopAnalyzer loops(graph.get(), &dom);
+    loops.Run();
+    LoopPredication predication(graph.get(), &dom, &loops);
+    predication.Run();
+    ASSERT_EQ(predication.GetVersionedCount(), static_cast<size_t>(1));
+    ASSERT_EQ(predication.GetRemovedCount(), static_cast<size_t>(2));
+    // only the slow copy keeps its checks
+    ASSERT_EQ(CountBoundsChecks(graph.get()), static_cast<size_t>(2));
+
+    dom.Run();
+    loops.Run();
+    ASSERT_EQ(loops.GetLoops().size(), static_cast<size_t>(2));
+
+    for (int64_t n : {-3, 0, 1, 5, 8, 9, 10}) {
+        for (int64_t len : {0, 2, 9, 10, 11, 12}) {
+            int64_t expected = Interpret(original.get(), {100, n, len});
+            ASSERT_EQ(Interpret(graph.get(), {100, n, len}), expected);
+        }
+    }
+    ASSERT_EQ(Interpret(graph.get(), {100, 9, 11}), Interpret(original.get(), {100, 9, 11}));
+    ASSERT_NOT_EQ(Interpret(graph.get(), {100, 9, 11}), kInterpretTrap);
+    ASSERT_EQ(Interpret(graph.get(), {100, 9, 10}), kInterpretTrap);
+}
+
+// the index i - 1 starts out of bounds, so the loop keeps its check
+void TestPredicationNegativeStart(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* arr = builder.CreateParameter(Type::int64);
+    auto* n = builder.CreateParameter(Type::int32);
+    auto* len = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(header);
+    auto* i = builder.CreatePhi(Type::int32);
+    builder.CreateIf(builder.CreateCmp(n, i), exit, body);
+
+    builder.SetInsertPoint(body);
+    auto* below = builder.CreateAdd(i, builder.CreateConstant(Type::int32, -1));
+    builder.CreateLoadArray(Type::int32, arr, builder.CreateBoundsCheck(below, len));
+    auto* i_next = builder.CreateAdd(i, c1);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(i);
+    i->AddPhiInput(entry, c0);
+    i->AddPhiInput(body, i_next);
+
+    PassManager pm(graph.get());
+    pm.AddPass<LoopPredication>();
+    pm.Run();
+    ASSERT_EQ(CountBoundsChecks(graph.get()), static_cast<size_t>(1));
+    ASSERT_EQ(graph->GetBlocks().size(), static_cast<size_t>(4));
+}
+
+// i = 0; while (a[i], i < n) i++; the check in the header also runs for
+// i = n, which the guard does not cover
+static std::unique_ptr<Graph> BuildHeaderCheckGraph() {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* arr = builder.CreateParameter(Type::int64);
+    auto* n = builder.CreateParameter(Type::int32);
+    auto* len = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(header);
+    auto* i = builder.CreatePhi(Type::int32);
+    builder.CreateLoadArray(Type::int32, arr, builder.CreateBoundsCheck(i, len));
+    builder.CreateIf(builder.CreateCmp(n, i), exit, body);
+
+    builder.SetInsertPoint(body);
+    auto* i_next = builder.CreateAdd(i, c1);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(i);
+    i->AddPhiInput(entry, c0);
+    i->AddPhiInput(body, i_next);
+    return graph;
+}
+
+void TestPredicationKeepsHeaderCheck(TestRunner& t) {
+    auto original = BuildHeaderCheckGraph();
+    auto graph = BuildHeaderCheckGraph();
+    PassManager pm(graph.get());
+    pm.AddPass<LoopPredication>();
+    pm.Run();
+
+    ASSERT_EQ(CountBoundsChecks(graph.get()), static_cast<size_t>(1));
+    ASSERT_EQ(Interpret(graph.get(), {100, 5, 5}), kInterpretTrap);
+    for (int64_t n : {-1, 0, 4, 5}) {
+        for (int64_t len : {0, 4, 5, 6}) {
+            ASSERT_EQ(Interpret(graph.get(), {100, n, len}), Interpret(original.get(), {100, n, len}));
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#include "CheckElimination.hpp"
+#include "RangeAnalysis.hpp"
+#include "PassManager.hpp"
+#include "IRBuilder.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+// for (i = 0; i < len; i++) s += a[i]
+void TestRangeCheckInCountedLoop(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* arr = builder.CreateParameter(Type::int64);
+    auto* len = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(header);
+    auto* s = builder.CreatePhi(Type::int32);
+    auto* i = builder.CreatePhi(Type::int32);
+    // len <= i leaves the loop
+    builder.CreateIf(builder.CreateCmp(len, i), exit, body);
+
+    builder.SetInsertPoint(body);
+    auto* check = builder.CreateBoundsCheck(i, len);
+    auto* load = builder.CreateLoadArray(Type::int32, arr, check);
+    // i - 1 may be negative
+    auto* below = builder.CreateAdd(i, builder.CreateConstant(Type::int32, -1));
+    auto* below_check = builder.CreateBoundsCheck(below, len);
+    builder.CreateLoadArray(Type::int32, arr, below_check);
+    auto* s_next = builder.CreateAdd(s, load);
+    auto* i_next = builder.CreateAdd(i, c1);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(s);
+    s->AddPhiInput(entry, c0);
+    s->AddPhiInput(body, s_next);
+    i->AddPhiInput(entry, c0);
+    i->AddPhiInput(body, i_next);
+
+    DominatorAnalysis dom(graph.get());
+    dom.Run();
+    LoopAnalyzer loops(graph.get(), &dom);
+    loops.Run();
+    RangeAnalysis ranges(graph.get(), &dom, &loops);
+    ranges.Run();
+    ASSERT_EQ(ranges.GetRange(i).min, 0);
+    ASSERT_EQ(ranges.GetRange(i).max, static_cast<int64_t>(INT32_MAX));
+    ASSERT_EQ(ranges.GetRangeAt(i, body).max, static_cast<int64_t>(INT32_MAX) - 1);
+    ASSERT_EQ(ranges.ProvesLess(i, len, body), true);
+    ASSERT_EQ(ranges.ProvesLess(i, len, exit), false);
+
+    CheckElimination ce(graph.get(), &dom, &loops);
+    ce.Run();
+    ASSERT_EQ(ce.GetProvenCount(), 1);
+    ASSERT_EQ(load->GetInput(1), static_cast<Instruction*>(i));
+    ASSERT_EQ(below_check->GetBasicBlock(), body);
+}
+
+// if (n <= 9) { for (i = 0; i <= n; i++) a[i] } against a length of 10
+void TestRangeFromLoopGuard(TestRunner& t) {
+    for (bool guarded : {true, false}) {
+        auto graph = std::make_unique<Graph>();
+        IRBuilder builder(graph.get());
+        auto* entry = graph->CreateNewBasicBlock();
+        auto* guard = graph->CreateNewBasicBlock();
+        auto* header = graph->CreateNewBasicBlock();
+        auto* body = graph->CreateNewBasicBlock();
+        auto* exit = graph->CreateNewBasicBlock();
+        graph->SetEntryBlock(entry);
+
+        builder.SetInsertPoint(entry);
+        auto* arr = builder.CreateParameter(Type::int64);
+        auto* n = builder.CreateParameter(Type::int32);
+        auto* c0 = builder.CreateConstant(Type::int32, 0);
+        auto* c1 = builder.CreateConstant(Type::int32, 1);
+        auto* c9 = builder.CreateConstant(Type::int32, guarded ? 9 : 10);
+        auto* c10 = builder.CreateConstant(Type::int32, 10);
+        builder.CreateIf(builder.CreateCmp(n, c9), guard, exit);
+        builder.SetInsertPoint(guard);
+        builder.CreateJump(header);
+
+        builder.SetInsertPoint(header);
+        auto* i = builder.CreatePhi(Type::int32);
+        builder.CreateIf(builder.CreateCmp(i, n), body, exit);
+        builder.SetInsertPoint(body);
+        auto* check = builder.CreateBoundsCheck(i, c10);
+        builder.CreateLoadArray(Type::int32, arr, check);
+        auto* i_next = builder.CreateAdd(i, c1);
+        builder.CreateJump(header);
+        builder.SetInsertPoint(exit);
+        builder.CreateReturn(c0);
+        i->AddPhiInput(guard, c0);
+        i->AddPhiInput(body, i_next);
+
+        PassManager pm(graph.get());
+        pm.AddPass<CheckElimination>();
+        pm.Run();
+
+        bool removed = true;
+        for (auto* inst = body->GetFirstInst(); inst; inst = inst->GetNext()) {
+            removed &= inst->GetOpcode() != Opcode::BoundsCheck;
+        }
+        ASSERT_EQ(removed, guarded);
+    }
+}
@@ -0,0 +1,101 @@
+#include "Reassociate.hpp"
+#include "LICM.hpp"
+#include "PassManager.hpp"
+#include "IRBuilder.hpp"
+#include "Interpreter.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+int64_t GetConstVal(Instruction* inst);
+
+// ((x + 1) + 2) + y and (x * 4) * 8
+void TestReassociateConstantChains(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* bb = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(bb);
+    builder.SetInsertPoint(bb);
+
+    auto* x = builder.CreateParameter(Type::int32);
+    auto* y = builder.CreateParameter(Type::int32);
+    auto* sum = builder.CreateAdd(builder.CreateAdd(builder.CreateAdd(x, builder.CreateConstant(Type::int32, 1)),
+                                                    builder.CreateConstant(Type::int32, 2)), y);
+    auto* ret_sum = builder.CreateReturn(sum);
+    auto* product = builder.CreateMul(builder.CreateMul(x, builder.CreateConstant(Type::int32, 4)),
+                                      builder.CreateConstant(Type::int32, 8));
+    auto* ret_product = builder.CreateReturn(product);
+
+    Reassociate reassociate(graph.get());
+    reassociate.Run();
+    ASSERT_EQ(reassociate.GetRewrittenCount(), static_cast<size_t>(2));
+    ASSERT_EQ(reassociate.GetRemovedCount(), static_cast<size_t>(2));
+
+    Instruction* add = ret_sum->GetInput(0);
+    ASSERT_EQ(add->GetOpcode(), Opcode::Add);
+    ASSERT_EQ(GetConstVal(add->GetInput(1)), 3);
+    Instruction* inner = add->GetInput(0);
+    ASSERT_EQ(inner->GetOpcode(), Opcode::Add);
+    ASSERT_EQ(inner->GetInput(0), static_cast<Instruction*>(x));
+    ASSERT_EQ(inner->GetInput(1), static_cast<Instruction*>(y));
+
+    Instruction* mul = ret_product->GetInput(0);
+    ASSERT_EQ(mul->GetInput(0), static_cast<Instruction*>(x));
+    ASSERT_EQ(GetConstVal(mul->GetInput(1)), 32);
+
+    // the result is already canonical
+    Reassociate again(graph.get());
+    again.Run();
+    ASSERT_EQ(again.GetRewrittenCount(), static_cast<size_t>(0));
+}
+
+// for (i = 0; i <= n; i++) s = s + ((i + a) + b) - after reassociation
+// a + b no longer depends on i and leaves the loop
+void TestReassociateExposesInvariant(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* n = builder.CreateParameter(Type::int32);
+    auto* a = builder.CreateParameter(Type::int32);
+    auto* b = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(header);
+    auto* s = builder.CreatePhi(Type::int32);
+    auto* i = builder.CreatePhi(Type::int32);
+    builder.CreateIf(builder.CreateCmp(i, n), body, exit);
+
+    builder.SetInsertPoint(body);
+    auto* term = builder.CreateAdd(builder.CreateAdd(i, a), b);
+    auto* s_next = builder.CreateAdd(s, term);
+    auto* i_next = builder.CreateAdd(i, c1);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(s);
+    s->AddPhiInput(entry, c0);
+    s->AddPhiInput(body, s_next);
+    i->AddPhiInput(entry, c0);
+    i->AddPhiInput(body, i_next);
+
+    std::vector<std::vector<int64_t>> inputs = {{-1, 3, 4}, {0, 3, 4}, {10, -7, 2}};
+    std::vector<int64_t> expected;
+    for (const auto& args : inputs) expected.push_back(Interpret(graph.get(), args));
+
+    AnalysisManager am(graph.get());
+    Reassociate reassociate(graph.get());
+    reassociate.Run();
+    am.Invalidate(reassociate.GetPreservedAnalyses());
+    LICM licm(graph.get(), am);
+    licm.Run();
+    ASSERT_EQ(licm.GetHoistedCount(), static_cast<size_t>(1));
+
+    for (size_t k = 0; k < inputs.size(); ++k) ASSERT_EQ(Interpret(graph.get(), inputs[k]), expected[k]);
+}
@@ -0,0 +1,89 @@
+#include "SCCP.hpp"
+#include "IRBuilder.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+int64_t GetConstVal(Instruction* inst);
+
+// x = 5; while (x <= 3) { x = x * 1; } return x + 1
+void TestSCCPConstantLoopVanishes(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    auto* c3 = builder.CreateConstant(Type::int32, 3);
+    auto* c5 = builder.CreateConstant(Type::int32, 5);
+    builder.CreateJump(header);
+    builder.SetInsertPoint(header);
+    auto* x = builder.CreatePhi(Type::int32);
+    builder.CreateIf(builder.CreateCmp(x, c3), body, exit);
+    builder.SetInsertPoint(body);
+    auto* next = builder.CreateMul(x, c1);
+    builder.CreateJump(header);
+    builder.SetInsertPoint(exit);
+    auto* ret = builder.CreateReturn(builder.CreateAdd(x, c1));
+    x->AddPhiInput(entry, c5);
+    x->AddPhiInput(body, next);
+
+    SCCP sccp(graph.get());
+    sccp.Run();
+
+    ASSERT_EQ(sccp.GetFoldedBranchCount(), static_cast<size_t>(1));
+    ASSERT_EQ(GetConstVal(ret->GetInput(0)), 6);
+    ASSERT_EQ(graph->GetBlocks().size(), static_cast<size_t>(3));
+    ASSERT_EQ(header->GetFirstPhi(), nullptr);
+    ASSERT_EQ(header->GetLastInst()->GetOpcode(), Opcode::Jump);
+    ASSERT_EQ(header->GetPreds().size(), static_cast<size_t>(1));
+
+    // a second run finds nothing left and reports only its own work
+    sccp.Run();
+    ASSERT_EQ(sccp.GetFoldedBranchCount(), static_cast<size_t>(0));
+    ASSERT_EQ(sccp.GetPreservedAnalyses().IsPreserved(AnalysisKind::Dominators), true);
+}
+
+// the phi merges 2 from both arms, only one of which can run
+void TestSCCPThroughPhis(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* left = graph->CreateNewBasicBlock();
+    auto* right = graph->CreateNewBasicBlock();
+    auto* join = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* p = builder.CreateParameter(Type::int32);
+    auto* c2 = builder.CreateConstant(Type::int32, 2);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateIf(p, left, right);
+    builder.SetInsertPoint(left);
+    auto* two = builder.CreateAdd(c1, c1);
+    builder.CreateJump(join);
+    builder.SetInsertPoint(right);
+    builder.CreateJump(join);
+    builder.SetInsertPoint(join);
+    auto* phi = builder.CreatePhi(Type::int32);
+    phi->AddPhiInput(left, two);
+    phi->AddPhiInput(right, c2);
+    auto* mixed = builder.CreatePhi(Type::int32);
+    mixed->AddPhiInput(left, p);
+    mixed->AddPhiInput(right, c2);
+    auto* ret = builder.CreateReturn(builder.CreateOr(phi, mixed));
+
+    SCCP sccp(graph.get());
+    sccp.Run();
+
+    ASSERT_EQ(sccp.GetFoldedBranchCount(), static_cast<size_t>(0));
+    ASSERT_EQ(sccp.GetValue(mixed).kind == SCCP::LatticeValue::Kind::Overdefined, true);
+    ASSERT_EQ(graph->GetBlocks().size(), static_cast<size_t>(4));
+    auto* orr = ret->GetInput(0);
+    ASSERT_EQ(GetConstVal(orr->GetInput(0)), 2);
+    ASSERT_EQ(orr->GetInput(1), static_cast<Instruction*>(mixed));
+    ASSERT_EQ(join->GetFirstPhi(), static_cast<Instruction*>(mixed));
+}
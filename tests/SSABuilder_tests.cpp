@@ -0,0 +1,121 @@
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+#include "IRBuilder.hpp"
+
+static size_t CountPhis(BasicBlock* bb) {
+    size_t count = 0;
+    for (auto* inst = bb->GetFirstPhi(); inst; inst = inst->GetNext()) count++;
+    return count;
+}
+
+// res = 1; i = 1; while (i <= n) { res = res * i; i = i + 1; } return res;
+void TestSSAFactorialLoop(TestRunner& t) {
+    Graph graph;
+    IRBuilder builder(&graph);
+    BasicBlock* entry = graph.CreateNewBasicBlock();
+    BasicBlock* header = graph.CreateNewBasicBlock();
+    BasicBlock* body = graph.CreateNewBasicBlock();
+    BasicBlock* exit = graph.CreateNewBasicBlock();
+    graph.SetEntryBlock(entry);
+
+    int res = builder.DeclareVariable(Type::int64);
+    int i = builder.DeclareVariable(Type::int64);
+    int n = builder.DeclareVariable(Type::int64);
+
+    builder.SetInsertPoint(entry);
+    builder.SealBlock(entry);
+    auto* param = builder.CreateParameter(Type::int64);
+    auto* one = builder.CreateConstant(Type::int64, int64_t{1});
+    builder.WriteVariable(n, param);
+    builder.WriteVariable(res, one);
+    builder.WriteVariable(i, one);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(header);
+    auto* cond = builder.CreateCmp(builder.ReadVariable(i), builder.ReadVariable(n));
+    builder.CreateIf(cond, body, exit);
+
+    builder.SetInsertPoint(body);
+    builder.SealBlock(body);
+    builder.WriteVariable(res, builder.CreateMul(builder.ReadVariable(res), builder.ReadVariable(i)));
+    builder.WriteVariable(i, builder.CreateAdd(builder.ReadVariable(i), one));
+    builder.CreateJump(header);
+    builder.SealBlock(header);
+
+    builder.SetInsertPoint(exit);
+    builder.SealBlock(exit);
+    auto* ret = builder.CreateReturn(builder.ReadVariable(res));
+
+    // n never changes inside the loop, so only res and i get phis
+    ASSERT_EQ(CountPhis(header), static_cast<size_t>(2));
+    ASSERT_EQ(CountPhis(body), static_cast<size_t>(0));
+    ASSERT_EQ(CountPhis(exit), static_cast<size_t>(0));
+    ASSERT_EQ(cond->GetInput(1), static_cast<Instruction*>(param));
+
+    auto* res_phi = dyn_cast<PhiInst>(ret->GetInput(0));
+    ASSERT_NOT_EQ(res_phi, nullptr);
+    ASSERT_EQ(res_phi->GetBasicBlock(), header);
+    ASSERT_EQ(res_phi->GetPhiInputs()[0].first, entry);
+    ASSERT_EQ(res_phi->GetPhiInputs()[0].second, static_cast<Instruction*>(one));
+    ASSERT_EQ(res_phi->GetPhiInputs()[1].first, body);
+    ASSERT_EQ(res_phi->GetPhiInputs()[1].second->GetOpcode(), Opcode::Mul);
+}
+
+void TestSSATrivialPhisRemoved(TestRunner& t) {
+    Graph graph;
+    IRBuilder builder(&graph);
+    BasicBlock* entry = graph.CreateNewBasicBlock();
+    BasicBlock* left = graph.CreateNewBasicBlock();
+    BasicBlock* right = graph.CreateNewBasicBlock();
+    BasicBlock* join = graph.CreateNewBasicBlock();
+    BasicBlock* loop = graph.CreateNewBasicBlock();
+    BasicBlock* done = graph.CreateNewBasicBlock();
+    graph.SetEntryBlock(entry);
+
+    int x = builder.DeclareVariable(Type::int32);
+    builder.SetInsertPoint(entry);
+    builder.SealBlock(entry);
+    auto* param = builder.CreateParameter(Type::int32);
+    builder.WriteVariable(x, param);
+    builder.CreateIf(param, left, right);
+
+    for (auto* bb : {left, right}) {
+        builder.SetInsertPoint(bb);
+        builder.SealBlock(bb);
+        builder.CreateJump(join);
+    }
+
+    // x is untouched on both paths and around the self loop
+    builder.SetInsertPoint(join);
+    builder.CreateJump(loop);
+    builder.SealBlock(join);
+    builder.SetInsertPoint(loop);
+    auto* use = builder.CreateAdd(builder.ReadVariable(x), param);
+    builder.CreateIf(use, loop, done);
+    builder.SealBlock(loop);
+
+    builder.SetInsertPoint(done);
+    builder.SealBlock(done);
+    ASSERT_EQ(builder.ReadVariable(x), static_cast<Instruction*>(param));
+    ASSERT_EQ(use->GetInput(0), static_cast<Instruction*>(param));
+    ASSERT_EQ(CountPhis(join), static_cast<size_t>(0));
+    ASSERT_EQ(CountPhis(loop), static_cast<size_t>(0));
+}
+
+void TestSSAUndefinedVariable(TestRunner& t) {
+    Graph graph;
+    IRBuilder builder(&graph);
+    BasicBlock* entry = graph.CreateNewBasicBlock();
+    graph.SetEntryBlock(entry);
+    int x = builder.DeclareVariable(Type::int32);
+    builder.SetInsertPoint(entry);
+    builder.SealBlock(entry);
+
+    bool thrown = false;
+    try {
+        builder.ReadVariable(x);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    ASSERT_EQ(thrown, true);
+}
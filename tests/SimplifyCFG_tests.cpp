@@ -0,0 +1,187 @@
+#include "SimplifyCFG.hpp"
+#include "Inliner.hpp"
+#include "IRBuilder.hpp"
+#include "Interpreter.hpp"
+#include "LoopAnalyzer.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+std::unique_ptr<Graph> BuildCalleeGraph();
+
+// entry -> a -> b -> if (p) c else d(empty) -> join
+void TestSimplifyCFGMergeAndRemove(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* a = graph->CreateNewBasicBlock();
+    auto* b = graph->CreateNewBasicBlock();
+    auto* c = graph->CreateNewBasicBlock();
+    auto* d = graph->CreateNewBasicBlock();
+    auto* join = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* p = builder.CreateParameter(Type::int32);
+    auto* x = builder.CreateParameter(Type::int32);
+    builder.CreateJump(a);
+    builder.SetInsertPoint(a);
+    auto* doubled = builder.CreateAdd(x, x);
+    builder.CreateJump(b);
+    builder.SetInsertPoint(b);
+    builder.CreateIf(p, c, d);
+    builder.SetInsertPoint(c);
+    auto* inc = builder.CreateAdd(doubled, builder.CreateConstant(Type::int32, 1));
+    builder.CreateJump(join);
+    builder.SetInsertPoint(d);
+    builder.CreateJump(join);
+    builder.SetInsertPoint(join);
+    auto* phi = builder.CreatePhi(Type::int32);
+    phi->AddPhiInput(c, inc);
+    phi->AddPhiInput(d, doubled);
+    builder.CreateReturn(phi);
+
+    SimplifyCFG simplify(graph.get());
+    simplify.Run();
+    ASSERT_EQ(simplify.GetMergedCount(), static_cast<size_t>(2));
+    ASSERT_EQ(simplify.GetRemovedCount(), static_cast<size_t>(1));
+    ASSERT_EQ(graph->GetBlocks().size(), static_cast<size_t>(3));
+    ASSERT_EQ(doubled->GetBasicBlock(), entry);
+    auto* branch = dyn_cast<IfInst>(entry->GetLastInst());
+    ASSERT_NOT_EQ(branch, nullptr);
+    if (branch) ASSERT_EQ(branch->GetFalseTarget(), join);
+    ASSERT_EQ(join->GetPreds().size(), static_cast<size_t>(2));
+
+    ASSERT_EQ(Interpret(graph.get(), {1, 5}), 11);
+    ASSERT_EQ(Interpret(graph.get(), {0, 5}), 10);
+
+    // nothing is left to simplify, so a second run keeps every analysis
+    simplify.Run();
+    ASSERT_EQ(simplify.GetMergedCount(), static_cast<size_t>(2));
+    ASSERT_EQ(simplify.GetPreservedAnalyses().IsPreserved(AnalysisKind::Dominators), true);
+}
+
+// flag = p ? 1 : 0; if (flag) return x; return y
+void TestSimplifyCFGThreadsJumps(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* left = graph->CreateNewBasicBlock();
+    auto* right = graph->CreateNewBasicBlock();
+    auto* merge = graph->CreateNewBasicBlock();
+    auto* on_true = graph->CreateNewBasicBlock();
+    auto* on_false = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* p = builder.CreateParameter(Type::int32);
+    auto* x = builder.CreateParameter(Type::int32);
+    auto* y = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateIf(p, left, right);
+    builder.SetInsertPoint(left);
+    builder.CreateJump(merge);
+    builder.SetInsertPoint(right);
+    builder.CreateJump(merge);
+    builder.SetInsertPoint(merge);
+    auto* flag = builder.CreatePhi(Type::int32);
+    flag->AddPhiInput(left, c1);
+    flag->AddPhiInput(right, c0);
+    builder.CreateIf(flag, on_true, on_false);
+    builder.SetInsertPoint(on_true);
+    builder.CreateReturn(x);
+    builder.SetInsertPoint(on_false);
+    builder.CreateReturn(y);
+
+    SimplifyCFG simplify(graph.get());
+    simplify.Run();
+    ASSERT_EQ(simplify.GetThreadedCount(), static_cast<size_t>(2));
+    ASSERT_EQ(graph->GetBlocks().size(), static_cast<size_t>(3));
+    // p now picks the return directly
+    auto* branch = dyn_cast<IfInst>(entry->GetLastInst());
+    ASSERT_NOT_EQ(branch, nullptr);
+    if (branch) ASSERT_EQ(branch->GetInput(0), static_cast<Instruction*>(p));
+    ASSERT_EQ(Interpret(graph.get(), {1, 7, 9}), 7);
+    ASSERT_EQ(Interpret(graph.get(), {0, 7, 9}), 9);
+}
+
+// the Inliner cleans up the blocks it splits by default
+void TestSimplifyCFGAfterInlining(TestRunner& t) {
+    auto callee = BuildCalleeGraph();
+    size_t block_counts[2] = {0, 0};
+    int64_t results[2] = {0, 0};
+    for (bool simplify : {false, true}) {
+        auto caller = std::make_unique<Graph>();
+        IRBuilder builder(caller.get());
+        auto* entry = caller->CreateNewBasicBlock();
+        auto* body = caller->CreateNewBasicBlock();
+        caller->SetEntryBlock(entry);
+        builder.SetInsertPoint(entry);
+        auto* a = builder.CreateParameter(Type::int32);
+        auto* b = builder.CreateParameter(Type::int32);
+        builder.CreateJump(body);
+        builder.SetInsertPoint(body);
+        auto* call = builder.CreateCall(Type::int32, callee.get(), {a, b});
+        builder.CreateReturn(builder.CreateAdd(call, a));
+
+        Inliner inliner(caller.get());
+        inliner.SetSimplifyCFG(simplify);
+        inliner.Run();
+        block_counts[simplify] = caller->GetBlocks().size();
+        results[simplify] = Interpret(caller.get(), {3, 20});
+    }
+    ASSERT_EQ(block_counts[0], static_cast<size_t>(7));
+    ASSERT_EQ(block_counts[1], static_cast<size_t>(4));
+    ASSERT_EQ(results[1], results[0]);
+}
+
+static size_t CountLoops(Graph* graph) {
+    DominatorAnalysis dom(graph);
+    dom.Run();
+    LoopAnalyzer loops(graph, &dom);
+    loops.Run();
+    return loops.GetLoops().size();
+}
+
+// c = p ? 1 : x; while (c) c = x - 1; return x
+// threading the constant edge past the header would enter the loop twice
+void TestSimplifyCFGKeepsLoopHeader(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* p1 = graph->CreateNewBasicBlock();
+    auto* p2 = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* p = builder.CreateParameter(Type::int32);
+    auto* x = builder.CreateParameter(Type::int32);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    builder.CreateIf(p, p1, p2);
+    builder.SetInsertPoint(p1);
+    builder.CreateJump(header);
+    builder.SetInsertPoint(p2);
+    builder.CreateJump(header);
+    builder.SetInsertPoint(header);
+    auto* c = builder.CreatePhi(Type::int32);
+    builder.CreateIf(c, body, exit);
+    builder.SetInsertPoint(body);
+    auto* y = builder.CreateSub(x, c1);
+    builder.CreateJump(header);
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(x);
+    c->AddPhiInput(p1, c1);
+    c->AddPhiInput(p2, x);
+    c->AddPhiInput(body, y);
+
+    ASSERT_EQ(CountLoops(graph.get()), static_cast<size_t>(1));
+    SimplifyCFG simplify(graph.get());
+    simplify.Run();
+    ASSERT_EQ(simplify.GetThreadedCount(), static_cast<size_t>(0));
+    ASSERT_EQ(CountLoops(graph.get()), static_cast<size_t>(1));
+    ASSERT_EQ(Interpret(graph.get(), {1, 1}), 1);
+    ASSERT_EQ(Interpret(graph.get(), {0, 0}), 0);
+}
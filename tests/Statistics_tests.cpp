@@ -0,0 +1,86 @@
+#include "Statistics.hpp"
+#include "Optimizer.hpp"
+#include "AnalysisManager.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+#include "BuildGraphs.hpp"
+
+static std::unique_ptr<Graph> BuildFoldableGraph() {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+    builder.SetInsertPoint(entry);
+    auto* c2 = builder.CreateConstant(Type::int32, 2);
+    auto* c3 = builder.CreateConstant(Type::int32, 3);
+    builder.CreateReturn(builder.CreateMul(c2, c3));
+    return graph;
+}
+
+void TestStatisticsDisabledByDefault(TestRunner& t) {
+    Statistics::Get().Reset();
+    auto graph = BuildFoldableGraph();
+    Optimizer opt(graph.get());
+    opt.Run();
+    ASSERT_EQ(Statistics::IsEnabled(), false);
+    ASSERT_EQ(Statistics::Get().Find(graph.get(), "Optimizer"), nullptr);
+    ASSERT_EQ(Statistics::Get().ToJson(), std::string("{\"graphs\":[],\"total\":{}}"));
+}
+
+void TestStatisticsPassCounters(TestRunner& t) {
+    Statistics::Get().Reset();
+    Statistics::SetEnabled(true);
+
+    auto folded = BuildFoldableGraph();
+    auto loop = BuildFactorialGraph();
+    Statistics::Get().SetGraphName(folded.get(), "fold");
+    Optimizer opt(folded.get());
+    opt.Run();
+    AnalysisManager am(loop.get());
+    am.Get<LoopAnalyzer>();
+    Statistics::SetEnabled(false);
+
+    const auto* record = Statistics::Get().Find(folded.get(), "Optimizer");
+    ASSERT_NOT_EQ(record, nullptr);
+    if (!record) return;
+    ASSERT_EQ(record->runs, static_cast<size_t>(1));
+    ASSERT_EQ(record->counters.at("folded"), int64_t{1});
+    ASSERT_EQ(record->counters.at("insts_before"), int64_t{4});
+    ASSERT_EQ(record->counters.at("blocks_after"), int64_t{1});
+
+    const auto* loops = Statistics::Get().Find(loop.get(), "LoopAnalyzer");
+    ASSERT_NOT_EQ(loops, nullptr);
+    ASSERT_NOT_EQ(Statistics::Get().Find(loop.get(), "DominatorAnalysis"), nullptr);
+    if (loops) ASSERT_EQ(loops->counters.at("loops"), int64_t{1});
+
+    std::string json = Statistics::Get().ToJson(folded.get());
+    ASSERT_EQ(json.rfind("{\"graph\":\"fold\",\"passes\":{\"Optimizer\":{\"runs\":1,", 0), static_cast<size_t>(0));
+    ASSERT_NOT_EQ(json.find("\"folded\":1"), std::string::npos);
+    std::string all = Statistics::Get().ToJson();
+    ASSERT_NOT_EQ(all.find("\"graph\":\"graph1\""), std::string::npos);
+    ASSERT_NOT_EQ(all.find("\"total\":{\"DominatorAnalysis\":{\"runs\":1"), std::string::npos);
+    Statistics::Get().Reset();
+}
+
+// the second graph is likely to reuse the first one's address
+void TestStatisticsGraphsInSequence(TestRunner& t) {
+    Statistics::Get().Reset();
+    Statistics::SetEnabled(true);
+    {
+        auto first = BuildFoldableGraph();
+        Statistics::Get().SetGraphName(first.get(), "first");
+        Optimizer opt(first.get());
+        opt.Run();
+    }
+    auto second = BuildFoldableGraph();
+    Optimizer opt(second.get());
+    opt.Run();
+    Statistics::SetEnabled(false);
+
+    ASSERT_EQ(Statistics::Get().ToJson(second.get()).rfind(
+        "{\"graph\":\"graph1\",\"passes\":{\"Optimizer\":{\"runs\":1,", 0), static_cast<size_t>(0));
+    std::string all = Statistics::Get().ToJson();
+    ASSERT_NOT_EQ(all.find("{\"graph\":\"first\",\"passes\":{\"Optimizer\":{\"runs\":1,"), std::string::npos);
+    ASSERT_NOT_EQ(all.find("\"total\":{\"Optimizer\":{\"runs\":2,"), std::string::npos);
+    Statistics::Get().Reset();
+}
@@ -0,0 +1,117 @@
+#include "StrengthReduction.hpp"
+#include "PassManager.hpp"
+#include "IRBuilder.hpp"
+#include "BuildGraphs.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+int64_t GetConstVal(Instruction* inst);
+
+void TestInductionVariables(TestRunner& t) {
+    auto graph = BuildFactorialGraph();
+    DominatorAnalysis dom(graph.get());
+    dom.Run();
+    LoopAnalyzer loops(graph.get(), &dom);
+    loops.Run();
+    InductionVariableAnalysis ivs(graph.get(), &loops);
+    ivs.Run();
+
+    BasicBlock* header = graph->GetBlocks()[1].get();
+    BasicBlock* body = graph->GetBlocks()[2].get();
+    auto* result_phi = header->GetFirstPhi();
+    auto* i_phi = result_phi->GetNext();
+    auto* new_result = body->GetFirstInst();
+    auto* new_i = new_result->GetNext();
+
+    ASSERT_EQ(ivs.GetBasicVariables().size(), static_cast<size_t>(1));
+    const auto* basic = ivs.GetBasicVariables()[0].get();
+    ASSERT_EQ(basic->phi, static_cast<PhiInst*>(i_phi));
+    ASSERT_EQ(basic->update, static_cast<BinaryInst*>(new_i));
+    ASSERT_EQ(basic->step, 1);
+    ASSERT_EQ(GetConstVal(basic->init), 1);
+
+    ASSERT_EQ(ivs.Get(new_i)->basic, basic);
+    ASSERT_EQ(ivs.Get(new_i)->scale, 1);
+    ASSERT_EQ(ivs.Get(new_i)->offset, 1);
+    ASSERT_EQ(ivs.Get(result_phi), static_cast<const InductionVariable*>(nullptr));
+    ASSERT_EQ(ivs.Get(new_result), static_cast<const InductionVariable*>(nullptr));
+}
+
+// i = 1; k = 0; m = 0
+// while (k <= n) { s += (i * 4) | (4 * i) | m; i++; k++; m++ } return s
+void TestStrengthReduction(TestRunner& t) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* n = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    auto* c4 = builder.CreateConstant(Type::int32, 4);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(header);
+    auto* s = builder.CreatePhi(Type::int32);
+    auto* i = builder.CreatePhi(Type::int32);
+    auto* k = builder.CreatePhi(Type::int32);
+    auto* m = builder.CreatePhi(Type::int32);
+    auto* cmp = builder.CreateCmp(k, n);
+    builder.CreateIf(cmp, body, exit);
+
+    builder.SetInsertPoint(body);
+    auto* scaled = builder.CreateMul(i, c4);
+    auto* scaled_again = builder.CreateMul(c4, i);
+    auto* mixed = builder.CreateOr(builder.CreateOr(scaled, scaled_again), m);
+    auto* s_next = builder.CreateAdd(s, mixed);
+    auto* i_next = builder.CreateAdd(i, c1);
+    auto* k_next = builder.CreateAdd(c1, k);
+    auto* m_next = builder.CreateAdd(m, c1);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(s);
+    s->AddPhiInput(entry, c0);
+    s->AddPhiInput(body, s_next);
+    i->AddPhiInput(entry, c1);
+    i->AddPhiInput(body, i_next);
+    k->AddPhiInput(entry, c0);
+    k->AddPhiInput(body, k_next);
+    m->AddPhiInput(entry, c0);
+    m->AddPhiInput(body, m_next);
+
+    PassManager pm(graph.get());
+    pm.AddPass<StrengthReduction>();
+    pm.Run();
+
+    // both multiplies become one phi stepping by 4 from 4
+    for (auto* inst = body->GetFirstInst(); inst; inst = inst->GetNext()) {
+        ASSERT_NOT_EQ(inst->GetOpcode(), Opcode::Mul);
+    }
+    auto* inner_or = mixed->GetInput(0);
+    auto* reduced = dyn_cast<PhiInst>(inner_or->GetInput(0));
+    ASSERT_NOT_EQ(reduced, static_cast<PhiInst*>(nullptr));
+    ASSERT_EQ(inner_or->GetInput(1), static_cast<Instruction*>(reduced));
+    ASSERT_EQ(reduced->GetBasicBlock(), header);
+    ASSERT_EQ(GetConstVal(reduced->GetPhiInputs()[0].second), 4);
+    auto* step = reduced->GetPhiInputs()[1].second;
+    ASSERT_EQ(step->GetBasicBlock(), body);
+    ASSERT_EQ(GetConstVal(step->GetInput(1)), 4);
+
+    // i only feeds its own update now and m duplicates k
+    ASSERT_EQ(header->GetFirstPhi(), static_cast<Instruction*>(s));
+    ASSERT_EQ(s->GetNext(), static_cast<Instruction*>(k));
+    ASSERT_EQ(k->GetNext(), static_cast<Instruction*>(reduced));
+    ASSERT_EQ(reduced->GetNext(), static_cast<Instruction*>(nullptr));
+    ASSERT_EQ(mixed->GetInput(1), static_cast<Instruction*>(k));
+    ASSERT_EQ(k_next->GetBasicBlock(), body);
+    // the dead updates of i and m went with them
+    size_t body_size = 0;
+    for (auto* inst = body->GetFirstInst(); inst; inst = inst->GetNext()) body_size++;
+    ASSERT_EQ(body_size, static_cast<size_t>(6));
+    ASSERT_EQ(cmp->GetInput(0), static_cast<Instruction*>(k));
+}
@@ -15,9 +15,57 @@ void TestConstantFolding(TestRunner& t);
 void TestPeepholeMul(TestRunner& t);
 void TestPeepholeOr(TestRunner& t);
 void TestPeepholeAshr(TestRunner& t);
+void TestPatternMatch(TestRunner& t);
+void TestPeepholeSubAndShift(TestRunner& t);
+void TestInstVisitorDispatch(TestRunner& t);
+void TestUseListReplaceAllUses(TestRunner& t);
+void TestWorklistLongChains(TestRunner& t);
+void TestFoldingWraparound(TestRunner& t);
+void TestBranchFolding(TestRunner& t);
+void TestSelfReferencingPhi(TestRunner& t);
+void TestDCERemovesDeadValues(TestRunner& t);
+void TestDCEReusesMemory(TestRunner& t);
+void TestGVNDominatedDuplicates(TestRunner& t);
+void TestGVNInPassManager(TestRunner& t);
+void TestSCCPConstantLoopVanishes(TestRunner& t);
+void TestSCCPThroughPhis(TestRunner& t);
+void TestLICMInsertsPreheader(TestRunner& t);
+void TestLICMNestedLoops(TestRunner& t);
+void TestInductionVariables(TestRunner& t);
+void TestStrengthReduction(TestRunner& t);
+void TestFullUnroll(TestRunner& t);
+void TestPartialUnroll(TestRunner& t);
+void TestPartialUnrollHeaderCall(TestRunner& t);
+void TestUnrollSkipsUnknownTripCount(TestRunner& t);
+void TestRangeCheckInCountedLoop(TestRunner& t);
+void TestRangeFromLoopGuard(TestRunner& t);
+void TestPredicationVersionsLoop(TestRunner& t);
+void TestPredicationNegativeStart(TestRunner& t);
+void TestPredicationKeepsHeaderCheck(TestRunner& t);
+void TestReassociateConstantChains(TestRunner& t);
+void TestReassociateExposesInvariant(TestRunner& t);
+void TestSimplifyCFGMergeAndRemove(TestRunner& t);
+void TestSimplifyCFGThreadsJumps(TestRunner& t);
+void TestSimplifyCFGAfterInlining(TestRunner& t);
+void TestSimplifyCFGKeepsLoopHeader(TestRunner& t);
+void TestGraphClonerCloneGraph(TestRunner& t);
+void TestGraphClonerSharesConstants(TestRunner& t);
 
 void TestLoops(TestRunner& t);
+void TestRPOCachedAndIterative(TestRunner& t);
+void TestBlockAndInstMaps(TestRunner& t);
+void TestSSAFactorialLoop(TestRunner& t);
+void TestSSATrivialPhisRemoved(TestRunner& t);
+void TestSSAUndefinedVariable(TestRunner& t);
+void TestAnalysisManagerCaching(TestRunner& t);
+void TestPassManagerPreservedAnalyses(TestRunner& t);
+void TestStatisticsDisabledByDefault(TestRunner& t);
+void TestStatisticsPassCounters(TestRunner& t);
+void TestStatisticsGraphsInSequence(TestRunner& t);
 void TestInliningSlideExample(TestRunner& t);
+void TestInliningRecursionLimit(TestRunner& t);
+void TestInliningPrefersLoopCalls(TestRunner& t);
+void TestInliningConstantArguments(TestRunner& t);
 
 void TestNullCheckRedundant(TestRunner& t);
 void TestNullCheckNoRemoveDifferentValues(TestRunner& t);
@@ -25,6 +73,10 @@ void TestChecksInSameBlock(TestRunner& t);
 void TestChecksDiamondNoElimination(TestRunner& t);
 void TestBoundsCheckDifferentLength(TestRunner& t);
 
+void TestArenaReusesFreedSlots(TestRunner& t);
+void TestGraphAllocatorRouting(TestRunner& t);
+void TestSmallVectorInlineStorage(TestRunner& t);
+
 void TestFactorialGraph(TestRunner& t) {
     auto graph = BuildFactorialGraph();
     assert(graph != nullptr);
@@ -106,6 +158,33 @@ void TestExample1(TestRunner& t) {
     ASSERT_EQ(loop_analyzer.GetLoops().size(), static_cast<size_t>(0));
 }
 
+void TestDominatorTree(TestRunner& t) {
+    std::map<std::string_view, BasicBlock*> blocks {};
+    auto graph = BuildExample1Graph(blocks);
+    BasicBlock* dead = graph->CreateNewBasicBlock();
+    dead->LinkTo(blocks["G"]);
+    DominatorAnalysis analysis(graph.get());
+    analysis.Run();
+
+    ASSERT_EQ(analysis.GetChildren(blocks["A"]).size(), static_cast<size_t>(1));
+    ASSERT_EQ(analysis.GetChildren(blocks["B"]).size(), static_cast<size_t>(3));
+    ASSERT_EQ(analysis.GetPreOrder().front(), blocks["A"]);
+    ASSERT_EQ(analysis.GetPreOrder().size(), static_cast<size_t>(7));
+
+    ASSERT_EQ(analysis.Dominates(blocks["A"], blocks["A"]), true);
+    ASSERT_EQ(analysis.Dominates(blocks["B"], blocks["G"]), true);
+    ASSERT_EQ(analysis.Dominates(blocks["F"], blocks["E"]), true);
+    ASSERT_EQ(analysis.Dominates(blocks["C"], blocks["E"]), false);
+    ASSERT_EQ(analysis.Dominates(blocks["G"], blocks["F"]), false);
+
+    // an unreachable predecessor changes nothing and dominates nothing
+    ASSERT_EQ(analysis.GetIdom(blocks["G"]), blocks["F"]);
+    ASSERT_EQ(analysis.IsReachable(dead), false);
+    ASSERT_EQ(analysis.GetIdom(dead), nullptr);
+    ASSERT_EQ(analysis.Dominates(dead, blocks["G"]), false);
+    ASSERT_EQ(analysis.Dominates(blocks["A"], dead), false);
+}
+
 void TestExample2(TestRunner& t) {
     std::map<std::string_view, BasicBlock*> blocks {};
     auto graph = BuildExample2Graph(blocks);
@@ -264,19 +343,73 @@ void TestExample6(TestRunner& t) {
     ASSERT_EQ(loopA->Contains(blocks["A"]), true);
     ASSERT_EQ(loopA->Contains(blocks["H"]), true);
     ASSERT_EQ(loopA->Contains(blocks["B"]), true);
+
+    ASSERT_EQ(loops.GetLoopFor(blocks["F"]), loopB);
+    ASSERT_EQ(loops.GetLoopFor(blocks["H"]), loopA);
+    ASSERT_EQ(loops.GetLoopDepth(blocks["F"]), 2);
+    ASSERT_EQ(loops.GetLoopDepth(blocks["H"]), 1);
+    ASSERT_EQ(loops.IsBackEdge(blocks["G"], blocks["B"]), true);
+    ASSERT_EQ(loops.IsBackEdge(blocks["H"], blocks["A"]), true);
+    ASSERT_EQ(loops.IsBackEdge(blocks["A"], blocks["B"]), false);
 }
 int main() {
     TestRunner runner;
     
     runner.AddTest("Example 1 Dominators & Loops", TestExample1);
+    runner.AddTest("Dominator Tree Numbering", TestDominatorTree);
     runner.AddTest("Example 2 Dominators & Loops", TestExample2);
     runner.AddTest("Example 3 Dominators & Loops", TestExample3);
     runner.AddTest("Loop Analysis Factorial", TestLoops);
+    runner.AddTest("Graph: Cached Iterative RPO", TestRPOCachedAndIterative);
+    runner.AddTest("Graph: Block And Inst Maps", TestBlockAndInstMaps);
+    runner.AddTest("SSA: Factorial Loop", TestSSAFactorialLoop);
+    runner.AddTest("SSA: Trivial Phis Removed", TestSSATrivialPhisRemoved);
+    runner.AddTest("SSA: Undefined Variable", TestSSAUndefinedVariable);
+    runner.AddTest("Passes: Cached Analyses", TestAnalysisManagerCaching);
+    runner.AddTest("Passes: Preserved Analyses", TestPassManagerPreservedAnalyses);
+    runner.AddTest("Stats: Disabled By Default", TestStatisticsDisabledByDefault);
+    runner.AddTest("Stats: Pass Counters And JSON", TestStatisticsPassCounters);
+    runner.AddTest("Stats: Graphs In Sequence", TestStatisticsGraphsInSequence);
     // optimizations tests
     runner.AddTest("Opt: Constant Folding", TestConstantFolding);
     runner.AddTest("Opt: Peephole MUL", TestPeepholeMul);
     runner.AddTest("Opt: Peephole OR", TestPeepholeOr);
     runner.AddTest("Opt: Peephole ASHR", TestPeepholeAshr);
+    runner.AddTest("Opt: Pattern Match", TestPatternMatch);
+    runner.AddTest("Opt: Peephole SUB and SHL", TestPeepholeSubAndShift);
+    runner.AddTest("Opt: InstVisitor Dispatch", TestInstVisitorDispatch);
+    runner.AddTest("Opt: Use Lists Replace All Uses", TestUseListReplaceAllUses);
+    runner.AddTest("Opt: Worklist Long Chains", TestWorklistLongChains);
+    runner.AddTest("Opt: Folding Wraparound", TestFoldingWraparound);
+    runner.AddTest("Opt: Branch Folding", TestBranchFolding);
+    runner.AddTest("Opt: Self Referencing Phi", TestSelfReferencingPhi);
+    runner.AddTest("DCE: Dead Values And Blocks", TestDCERemovesDeadValues);
+    runner.AddTest("DCE: Swept Memory Reused", TestDCEReusesMemory);
+    runner.AddTest("GVN: Dominated Duplicates", TestGVNDominatedDuplicates);
+    runner.AddTest("GVN: Pass Manager", TestGVNInPassManager);
+    runner.AddTest("SCCP: Constant Loop Vanishes", TestSCCPConstantLoopVanishes);
+    runner.AddTest("SCCP: Through Phis", TestSCCPThroughPhis);
+    runner.AddTest("LICM: Inserts Preheader", TestLICMInsertsPreheader);
+    runner.AddTest("LICM: Nested Loops", TestLICMNestedLoops);
+    runner.AddTest("IV: Basic And Derived", TestInductionVariables);
+    runner.AddTest("IV: Strength Reduction", TestStrengthReduction);
+    runner.AddTest("Unroll: Full", TestFullUnroll);
+    runner.AddTest("Unroll: Partial With Remainder", TestPartialUnroll);
+    runner.AddTest("Unroll: Partial Header Call Runs Once", TestPartialUnrollHeaderCall);
+    runner.AddTest("Unroll: Unknown Trip Count", TestUnrollSkipsUnknownTripCount);
+    runner.AddTest("Range: Check In Counted Loop", TestRangeCheckInCountedLoop);
+    runner.AddTest("Range: Loop Guard", TestRangeFromLoopGuard);
+    runner.AddTest("Predication: Versions Loop", TestPredicationVersionsLoop);
+    runner.AddTest("Predication: Negative Start", TestPredicationNegativeStart);
+    runner.AddTest("Predication: Keeps Header Check", TestPredicationKeepsHeaderCheck);
+    runner.AddTest("Reassociate: Constant Chains", TestReassociateConstantChains);
+    runner.AddTest("Reassociate: Exposes Invariant", TestReassociateExposesInvariant);
+    runner.AddTest("SimplifyCFG: Merge And Remove", TestSimplifyCFGMergeAndRemove);
+    runner.AddTest("SimplifyCFG: Threads Jumps", TestSimplifyCFGThreadsJumps);
+    runner.AddTest("SimplifyCFG: After Inlining", TestSimplifyCFGAfterInlining);
+    runner.AddTest("SimplifyCFG: Keeps Loop Header", TestSimplifyCFGKeepsLoopHeader);
+    runner.AddTest("GraphCloner: Clone Graph", TestGraphClonerCloneGraph);
+    runner.AddTest("GraphCloner: Shares Constants", TestGraphClonerSharesConstants);
     runner.AddTest("Loop: Example 4 (Basic Loop)", TestExample4);
     runner.AddTest("Loop: Example 5 (Shared Exit)", TestExample5);
     runner.AddTest("Loop: Example 6 (Nested Loops)", TestExample6);
@@ -292,6 +425,9 @@ int main() {
     runner.AddTest("RegAlloc: Graph 3 (Sequential + Branch)", TestRegAllocGraph3);
 
     runner.AddTest("Static Inlining (Slide Example)", TestInliningSlideExample);
+    runner.AddTest("Inlining: Recursion Limit", TestInliningRecursionLimit);
+    runner.AddTest("Inlining: Prefers Loop Calls", TestInliningPrefersLoopCalls);
+    runner.AddTest("Inlining: Constant Arguments", TestInliningConstantArguments);
 
     runner.AddTest("CheckElim: Redundant NullCheck+BoundsCheck", TestNullCheckRedundant);
     runner.AddTest("CheckElim: No Remove Different Values", TestNullCheckNoRemoveDifferentValues);
@@ -299,6 +435,10 @@ int main() {
     runner.AddTest("CheckElim: Diamond No Elimination", TestChecksDiamondNoElimination);
     runner.AddTest("CheckElim: BoundsCheck Different Length", TestBoundsCheckDifferentLength);
 
+    runner.AddTest("Alloc: Arena Reuses Freed Slots", TestArenaReusesFreedSlots);
+    runner.AddTest("Alloc: Graph Allocator Routing", TestGraphAllocatorRouting);
+    runner.AddTest("Alloc: SmallVector Inline Storage", TestSmallVectorInlineStorage);
+
     runner.RunAllTests();
     return (runner.GetFailedCount() > 0) ? 1 : 0;
 }
\ No newline at end of file
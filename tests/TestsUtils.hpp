@@ -9,6 +9,10 @@ inline std::ostream& operator<<(std::ostream& os, const Opcode& op) {
     return os << static_cast<int>(op);
 }
 
+inline std::ostream& operator<<(std::ostream& os, const Type& type) {
+    return os << static_cast<int>(type);
+}
+
 #define ASSERT_EQ(left, right) \
     t.AssertEqual(left, right, #left " == " #right " at " __FILE__ ":" + std::to_string(__LINE__))
 #define ASSERT_NOT_EQ(left, right) \
@@ -0,0 +1,181 @@
+#include "LoopUnroller.hpp"
+#include "Optimizer.hpp"
+#include "PassManager.hpp"
+#include "IRBuilder.hpp"
+#include "Interpreter.hpp"
+#include "TestRunner.hpp"
+#include "TestsUtils.hpp"
+
+// s = 0; i = start; while (i <= last) { t = i * 3; if (p) s += t else s |= t; i += step } return s + i
+static std::unique_ptr<Graph> BuildCountedLoop(int32_t start, int32_t last, int32_t step) {
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* left = graph->CreateNewBasicBlock();
+    auto* right = graph->CreateNewBasicBlock();
+    auto* latch = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* p = builder.CreateParameter(Type::int32);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c3 = builder.CreateConstant(Type::int32, 3);
+    auto* c_start = builder.CreateConstant(Type::int32, start);
+    auto* c_last = builder.CreateConstant(Type::int32, last);
+    auto* c_step = builder.CreateConstant(Type::int32, step);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(header);
+    auto* s = builder.CreatePhi(Type::int32);
+    auto* i = builder.CreatePhi(Type::int32);
+    builder.CreateIf(builder.CreateCmp(i, c_last), body, exit);
+
+    builder.SetInsertPoint(body);
+    auto* t = builder.CreateMul(i, c3);
+    builder.CreateIf(p, left, right);
+    builder.SetInsertPoint(left);
+    auto* added = builder.CreateAdd(s, t);
+    builder.CreateJump(latch);
+    builder.SetInsertPoint(right);
+    auto* ored = builder.CreateOr(s, t);
+    builder.CreateJump(latch);
+
+    builder.SetInsertPoint(latch);
+    auto* s_next = builder.CreatePhi(Type::int32);
+    s_next->AddPhiInput(left, added);
+    s_next->AddPhiInput(right, ored);
+    auto* i_next = builder.CreateAdd(i, c_step);
+    builder.CreateJump(header);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(builder.CreateAdd(s, i));
+    s->AddPhiInput(entry, c0);
+    s->AddPhiInput(latch, s_next);
+    i->AddPhiInput(entry, c_start);
+    i->AddPhiInput(latch, i_next);
+    return graph;
+}
+
+static size_t CountLoops(Graph* graph) {
+    DominatorAnalysis dom(graph);
+    dom.Run();
+    LoopAnalyzer loops(graph, &dom);
+    loops.Run();
+    return loops.GetLoops().size();
+}
+
+void TestFullUnroll(TestRunner& t) {
+    auto graph = BuildCountedLoop(2, 8, 2);
+    int64_t expected_add = Interpret(graph.get(), {1});
+    int64_t expected_or = Interpret(graph.get(), {0});
+
+    PassManager pm(graph.get());
+    pm.AddPass<LoopUnroller>();
+    pm.Run();
+
+    ASSERT_EQ(CountLoops(graph.get()), static_cast<size_t>(0));
+    ASSERT_EQ(Interpret(graph.get(), {1}), expected_add);
+    ASSERT_EQ(Interpret(graph.get(), {0}), expected_or);
+    // 4 iterations of body, left, right and latch plus entry and exit
+    ASSERT_EQ(graph->GetBlocks().size(), static_cast<size_t>(18));
+
+    // with the loop gone every i is a constant and the multiplies fold
+    Optimizer opt(graph.get());
+    opt.Run();
+    for (auto& bb : graph->GetBlocks()) {
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            ASSERT_NOT_EQ(inst->GetOpcode(), Opcode::Mul);
+        }
+    }
+    ASSERT_EQ(Interpret(graph.get(), {1}), expected_add);
+}
+
+void TestPartialUnroll(TestRunner& t) {
+    for (int32_t last : {29, 30, 31, 32}) {
+        auto graph = BuildCountedLoop(0, last, 1);
+        int64_t expected_add = Interpret(graph.get(), {1});
+        int64_t expected_or = Interpret(graph.get(), {0});
+
+        DominatorAnalysis dom(graph.get());
+        dom.Run();
+        LoopAnalyzer loops(graph.get(), &dom);
+        loops.Run();
+        LoopUnroller unroller(graph.get(), &loops);
+        unroller.SetFactor(4);
+        unroller.Run();
+
+        ASSERT_EQ(unroller.GetPartiallyUnrolledCount(), static_cast<size_t>(1));
+        // the unrolled loop and the remainder loop behind it
+        ASSERT_EQ(CountLoops(graph.get()), static_cast<size_t>(2));
+        ASSERT_EQ(Interpret(graph.get(), {1}), expected_add);
+        ASSERT_EQ(Interpret(graph.get(), {0}), expected_or);
+    }
+}
+
+// a trip count that can not be bounded leaves the loop alone
+void TestUnrollSkipsUnknownTripCount(TestRunner& t) {
+    auto graph = BuildCountedLoop(0, 5, 0);
+    DominatorAnalysis dom(graph.get());
+    dom.Run();
+    LoopAnalyzer loops(graph.get(), &dom);
+    loops.Run();
+    LoopUnroller unroller(graph.get(), &loops);
+    unroller.Run();
+    ASSERT_EQ(unroller.GetFullyUnrolledCount() + unroller.GetPartiallyUnrolledCount(), static_cast<size_t>(0));
+    ASSERT_EQ(unroller.GetPreservedAnalyses().IsPreserved(AnalysisKind::Loops), true);
+}
+
+// i = 0; while (f(i), i <= 30) i += 1; the call runs once per header visit
+void TestPartialUnrollHeaderCall(TestRunner& t) {
+    auto callee = std::make_unique<Graph>();
+    auto graph = std::make_unique<Graph>();
+    IRBuilder builder(graph.get());
+    auto* entry = graph->CreateNewBasicBlock();
+    auto* header = graph->CreateNewBasicBlock();
+    auto* body = graph->CreateNewBasicBlock();
+    auto* exit = graph->CreateNewBasicBlock();
+    graph->SetEntryBlock(entry);
+
+    builder.SetInsertPoint(entry);
+    auto* c0 = builder.CreateConstant(Type::int32, 0);
+    auto* c1 = builder.CreateConstant(Type::int32, 1);
+    auto* c30 = builder.CreateConstant(Type::int32, 30);
+    builder.CreateJump(header);
+    builder.SetInsertPoint(header);
+    auto* i = builder.CreatePhi(Type::int32);
+    builder.CreateCall(Type::int32, callee.get(), {i});
+    builder.CreateIf(builder.CreateCmp(i, c30), body, exit);
+    builder.SetInsertPoint(body);
+    auto* i_next = builder.CreateAdd(i, c1);
+    builder.CreateJump(header);
+    builder.SetInsertPoint(exit);
+    builder.CreateReturn(i);
+    i->AddPhiInput(entry, c0);
+    i->AddPhiInput(body, i_next);
+
+    DominatorAnalysis dom(graph.get());
+    dom.Run();
+    LoopAnalyzer loops(graph.get(), &dom);
+    loops.Run();
+    LoopUnroller unroller(graph.get(), &loops);
+    unroller.SetFactor(4);
+    unroller.Run();
+
+    ASSERT_EQ(unroller.GetPartiallyUnrolledCount(), static_cast<size_t>(1));
+    // a failed guard goes straight to the original header, so it must not
+    // have run a copy of the call first
+    BasicBlock* guard = entry->GetSuccs().front();
+    for (auto* inst = guard->GetFirstInst(); inst; inst = inst->GetNext()) {
+        ASSERT_NOT_EQ(inst->GetOpcode(), Opcode::Call);
+    }
+    size_t calls = 0;
+    for (auto& bb : graph->GetBlocks()) {
+        for (auto* inst = bb->GetFirstInst(); inst; inst = inst->GetNext()) {
+            if (inst->GetOpcode() == Opcode::Call) calls++;
+        }
+    }
+    ASSERT_EQ(calls, static_cast<size_t>(5));
+}